@@ -0,0 +1,143 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <string>
+#include <memory>
+#include <stdexcept>
+
+#ifdef PASSWORD_MAKER_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PASSWORD_MAKER_ZSTD
+#include <zstd.h>
+#endif
+
+namespace bwt {
+/// <summary> Compression of the output. </summary>
+enum class compression_t {
+	NONE,
+	GZIP,
+	ZSTD
+};
+
+/// <summary> Query if the compression is built in, libraries are found at configure time. </summary>
+/// <param name="compression"> The compression. </param>
+/// <returns> True if it is available. </returns>
+inline bool compression_available(const compression_t compression) {
+	switch (compression) {
+	case compression_t::NONE:
+		return true;
+	case compression_t::GZIP:
+#ifdef PASSWORD_MAKER_ZLIB
+		return true;
+#else
+		return false;
+#endif
+	case compression_t::ZSTD:
+#ifdef PASSWORD_MAKER_ZSTD
+		return true;
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+/// <summary> Gets the file extension appended for the compression. </summary>
+/// <param name="compression"> The compression. </param>
+/// <returns> The extension with its leading dot, empty if not compressed. </returns>
+inline std::string compression_extension(const compression_t compression) {
+	return compression == compression_t::GZIP ? ".gz" : compression == compression_t::ZSTD ? ".zst" : "";
+}
+
+/// <summary>
+///		<para> Compresses the block in place as an independent gzip member or zstd frame. </para>
+///		<para> Members and frames concatenated in any number form a valid stream, so blocks are compressed on every worker in parallel. </para>
+///	</summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <exception cref="std::runtime_error"> Thrown when the compression is not available or fails. </exception>
+/// <param name="compression"> The compression. </param>
+/// <param name="block">	   [in,out] The block, replaced by the compressed one. </param>
+inline void compress_block(const compression_t compression, std::string& block) {
+	if (compression == compression_t::NONE || block.empty()) {
+		return;
+	}
+	// Scratch buffer and compression context are reused by every block of the thread
+	static thread_local std::string compressed;
+#ifdef PASSWORD_MAKER_ZLIB
+	if (compression == compression_t::GZIP) {
+		struct deflater_t {
+			z_stream stream{};
+			bool initialized{ false };
+			~deflater_t() {
+				if (initialized) {
+					deflateEnd(&stream);
+				}
+			}
+		};
+		static thread_local deflater_t deflater;
+		if (!deflater.initialized) {
+			// Window bits above 15 select the gzip wrapper
+			if (deflateInit2(&deflater.stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+				throw std::runtime_error("failed to initialize deflate");
+			}
+			deflater.initialized = true;
+		} else {
+			deflateReset(&deflater.stream);
+		}
+		compressed.resize(deflateBound(&deflater.stream, static_cast<uLong>(block.size())));
+		deflater.stream.next_in = reinterpret_cast<Bytef*>(&block[0]);
+		deflater.stream.avail_in = static_cast<uInt>(block.size());
+		deflater.stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+		deflater.stream.avail_out = static_cast<uInt>(compressed.size());
+		if (deflate(&deflater.stream, Z_FINISH) != Z_STREAM_END) {
+			throw std::runtime_error("failed to deflate the block");
+		}
+		compressed.resize(deflater.stream.total_out);
+		block.swap(compressed);
+		return;
+	}
+#endif
+#ifdef PASSWORD_MAKER_ZSTD
+	if (compression == compression_t::ZSTD) {
+		static thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+		compressed.resize(ZSTD_compressBound(block.size()));
+		const auto size = ZSTD_compressCCtx(context.get(), &compressed[0], compressed.size(), block.data(), block.size(), ZSTD_CLEVEL_DEFAULT);
+		if (ZSTD_isError(size)) {
+			throw std::runtime_error(std::string("failed to compress the block: ") + ZSTD_getErrorName(size));
+		}
+		compressed.resize(size);
+		block.swap(compressed);
+		return;
+	}
+#endif
+	throw std::runtime_error("compression is not available in this build");
+}
+}	// namespace bwt
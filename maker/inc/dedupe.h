@@ -0,0 +1,533 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+namespace bwt {
+using fingerprint_t = std::uint64_t;
+
+/// <summary> Leading bytes of a saved fingerprint file. </summary>
+constexpr const char* FINGERPRINT_MAGIC = "PMFP0002";
+constexpr std::size_t FINGERPRINT_MAGIC_SIZE = 8;
+
+/// <summary> Modulus of the polynomial hash, the Mersenne prime 2^61 - 1. </summary>
+constexpr std::uint64_t HASH_MODULUS = (std::uint64_t(1) << 61) - 1;
+
+/// <summary> Base of the polynomial hash. </summary>
+constexpr std::uint64_t HASH_BASE = 0x1A2B3C4D5E6F7ULL;
+
+/// <summary>
+///		<para> Polynomial hash of a string and the base raised to its length. </para>
+///		<para> Hash of a concatenation is composed from the hashes of its parts without reading the bytes. </para>
+///	</summary>
+struct polynomial_hash_t {
+	std::uint64_t hash;
+	std::uint64_t power;
+};
+
+/// <summary> Reduces the value modulo HASH_MODULUS, the value must be less than 2^64 - 2^61. </summary>
+inline std::uint64_t hash_reduce(const std::uint64_t value) {
+	const auto reduced = (value & HASH_MODULUS) + (value >> 61);
+	return reduced >= HASH_MODULUS ? reduced - HASH_MODULUS : reduced;
+}
+
+/// <summary> Multiplies two values modulo HASH_MODULUS. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="lhs"> The left value, less than HASH_MODULUS. </param>
+/// <param name="rhs"> The right value, less than HASH_MODULUS. </param>
+/// <returns> The product. </returns>
+inline std::uint64_t hash_multiply(const std::uint64_t lhs, const std::uint64_t rhs) {
+#ifdef __SIZEOF_INT128__
+	const auto product = static_cast<unsigned __int128>(lhs) * rhs;
+	return hash_reduce((static_cast<std::uint64_t>(product) & HASH_MODULUS) + static_cast<std::uint64_t>(product >> 61));
+#else
+	// Split into 31 and 30 bits so that every partial product fits in 64 bits
+	constexpr std::uint64_t mask31 = (std::uint64_t(1) << 31) - 1;
+	constexpr std::uint64_t mask30 = (std::uint64_t(1) << 30) - 1;
+	const auto lhsHigh = lhs >> 31, lhsLow = lhs & mask31;
+	const auto rhsHigh = rhs >> 31, rhsLow = rhs & mask31;
+	const auto middle = lhsLow * rhsHigh + lhsHigh * rhsLow;
+	return hash_reduce(hash_reduce(lhsHigh * rhsHigh * 2 + (middle >> 30) + ((middle & mask30) << 31)) + lhsLow * rhsLow);
+#endif
+}
+
+/// <summary> Gets the hash of lhs followed by rhs. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="lhs"> The hash of the leading part. </param>
+/// <param name="rhs"> The hash of the trailing part. </param>
+/// <returns> The hash of the concatenation. </returns>
+inline polynomial_hash_t hash_concat(const polynomial_hash_t& lhs, const polynomial_hash_t& rhs) {
+	return { hash_reduce(hash_multiply(lhs.hash, rhs.power) + rhs.hash), hash_multiply(lhs.power, rhs.power) };
+}
+
+/// <summary> Polynomial hash of the data, every byte is taken as (byte + 1) so that leading zero bytes count. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="data">   The data. </param>
+/// <param name="length"> The length. </param>
+/// <returns> The hash. </returns>
+inline polynomial_hash_t polynomial_hash(const char* data, const std::size_t length) {
+	polynomial_hash_t result{ 0, 1 };
+	for (std::size_t i = 0; i < length; i++) {
+		result.hash = hash_reduce(hash_multiply(result.hash, HASH_BASE) + static_cast<unsigned char>(data[i]) + 1);
+		result.power = hash_multiply(result.power, HASH_BASE);
+	}
+	return result;
+}
+
+/// <summary> Mixes the 61-bit polynomial hash into a 64-bit fingerprint, high bits are used to pick stripes. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="hash"> The polynomial hash. </param>
+/// <returns> The fingerprint. </returns>
+inline fingerprint_t fingerprint(const polynomial_hash_t& hash) {
+	// Finalizer of MurmurHash3, a bijection so that equal hashes give equal fingerprints
+	auto value = hash.hash;
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCDULL;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53ULL;
+	value ^= value >> 33;
+	return value;
+}
+
+/// <summary> 64-bit fingerprint of a candidate, the same as the one composed from its parts. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="data">   The candidate data. </param>
+/// <param name="length"> The candidate length. </param>
+/// <returns> The fingerprint. </returns>
+inline fingerprint_t fingerprint(const char* data, const std::size_t length) {
+	return fingerprint(polynomial_hash(data, length));
+}
+
+/// <summary>
+///		<para> Single-writer open-addressing set of 64-bit fingerprints with linear probing. </para>
+///		<para> It is not thread-safe, the owner must serialize all accesses. </para>
+///	</summary>
+class FingerprintTable {
+public:
+	/// <summary> Constructor. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="capacity"> Initial number of slots, rounded up to a power of two. </param>
+	explicit FingerprintTable(const std::size_t capacity = INITIAL_CAPACITY) {
+		std::size_t slots = INITIAL_CAPACITY;
+		while (slots < capacity && slots < (std::size_t(1) << 30)) {
+			slots <<= 1;
+		}
+		_slots.assign(slots, fingerprint_t(EMPTY));
+	}
+
+	/// <summary> Inserts the fingerprint. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="value"> The fingerprint. </param>
+	/// <returns> True if it was not in the table before. </returns>
+	bool insert(fingerprint_t value) {
+		// Empty slot marker is never stored
+		value = (value == EMPTY) ? 1 : value;
+		if ((_size + 1) * 4 > _slots.size() * 3) {
+			grow();
+		}
+		if (!place(_slots, value)) {
+			return false;
+		}
+		_size++;
+		return true;
+	}
+
+	/// <summary> Number of fingerprints. </summary>
+	std::size_t size() const { return _size; }
+
+	/// <summary> Memory used by the slots in bytes. </summary>
+	std::uint64_t memory() const { return _slots.capacity() * sizeof(fingerprint_t); }
+
+	/// <summary> Invokes the function with every fingerprint. </summary>
+	template <typename Function>
+	void for_each(Function function) const {
+		std::for_each(_slots.cbegin(), _slots.cend(), [&](const fingerprint_t value) {
+			if (value != EMPTY) {
+				function(value);
+			} });
+	}
+
+private:
+	static constexpr fingerprint_t EMPTY = 0;
+	static constexpr std::size_t INITIAL_CAPACITY = 64;
+
+	/// <summary> Places the fingerprint with linear probing, capacity must be a power of two. </summary>
+	/// <returns> False if it already exists. </returns>
+	static bool place(std::vector<fingerprint_t>& slots, const fingerprint_t value) {
+		const auto mask = slots.size() - 1;
+		for (auto index = static_cast<std::size_t>(value) & mask;; index = (index + 1) & mask) {
+			if (slots[index] == value) {
+				return false;
+			}
+			if (slots[index] == EMPTY) {
+				slots[index] = value;
+				return true;
+			}
+		}
+	}
+
+	/// <summary> Doubles the capacity. </summary>
+	void grow() {
+		std::vector<fingerprint_t> slots(_slots.size() * 2, fingerprint_t(EMPTY));
+		for_each([&](const fingerprint_t value) { place(slots, value); });
+		_slots.swap(slots);
+	}
+
+	std::vector<fingerprint_t> _slots;
+	std::size_t _size{ 0 };
+};
+
+/// <summary>
+///		<para> Concurrent set of 64-bit fingerprints. </para>
+///		<para> Fingerprints are spread over lock-striped open-addressing tables by their high bits, </para>
+///		<para> so workers only contend when they hit the same stripe at the same time. </para>
+///	</summary>
+class FingerprintSet {
+public:
+	/// <summary> Constructor. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="expected"> Expected number of unique fingerprints, used to presize the stripes. </param>
+	explicit FingerprintSet(const std::size_t expected = 0) {
+		for (auto& stripe : _stripes) {
+			stripe.table = FingerprintTable(expected * 2 / STRIPE_NUMBER);
+		}
+	}
+
+	/// <summary> Inserts the fingerprint, thread-safe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="value"> The fingerprint. </param>
+	/// <returns> True if it was not in the set before. </returns>
+	bool insert(const fingerprint_t value) {
+		auto& stripe = _stripes[value >> (64 - STRIPE_BITS)];
+		std::lock_guard<std::mutex> lock(stripe.lock);
+		if (!stripe.table.insert(value)) {
+			return false;
+		}
+		_size++;
+		return true;
+	}
+
+	/// <summary> Number of unique fingerprints. </summary>
+	std::uint64_t size() const { return _size; }
+
+	/// <summary> Memory used by the tables in bytes. </summary>
+	std::uint64_t memory() const {
+		std::uint64_t bytes = 0;
+		for (const auto& stripe : _stripes) {
+			std::lock_guard<std::mutex> lock(stripe.lock);
+			bytes += stripe.table.memory();
+		}
+		return bytes;
+	}
+
+	/// <summary> Loads fingerprints saved by save(), a missing file is the same as an empty one. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the file is not a fingerprint file. </exception>
+	/// <param name="path"> The file path. </param>
+	/// <returns> Number of fingerprints loaded. </returns>
+	std::uint64_t load(const std::string& path) {
+		std::ifstream file(path, std::ifstream::binary);
+		if (!file) {
+			return 0;
+		}
+		char magic[FINGERPRINT_MAGIC_SIZE] = {};
+		if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, FINGERPRINT_MAGIC, sizeof(magic)) != 0) {
+			throw std::runtime_error(path + " is not a fingerprint file");
+		}
+		std::uint64_t loaded = 0;
+		std::vector<fingerprint_t> values(1 << 16);
+		while (file) {
+			file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(fingerprint_t)));
+			const auto count = static_cast<std::size_t>(file.gcount());
+			if (count % sizeof(fingerprint_t) != 0) {
+				throw std::runtime_error(path + " is truncated");
+			}
+			std::for_each(values.cbegin(), values.cbegin() + count / sizeof(fingerprint_t), [&](const fingerprint_t value) { insert(value); });
+			loaded += count / sizeof(fingerprint_t);
+		}
+		return loaded;
+	}
+
+	/// <summary> Saves all fingerprints in native byte order, the file is replaced only after it is completely written. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the file can not be written. </exception>
+	/// <param name="path"> The file path. </param>
+	void save(const std::string& path) const {
+		const auto temporary = path + ".tmp";
+		{
+			std::ofstream file(temporary, std::ofstream::binary | std::ofstream::trunc);
+			file.write(FINGERPRINT_MAGIC, FINGERPRINT_MAGIC_SIZE);
+			for (const auto& stripe : _stripes) {
+				std::lock_guard<std::mutex> lock(stripe.lock);
+				stripe.table.for_each([&](const fingerprint_t value) { file.write(reinterpret_cast<const char*>(&value), sizeof(value)); });
+			}
+			if (!file.flush()) {
+				std::remove(temporary.c_str());
+				throw std::runtime_error("failed to write " + temporary);
+			}
+		}
+		// Renaming onto an existing file fails on Windows
+		if (std::rename(temporary.c_str(), path.c_str()) != 0 && (std::remove(path.c_str()) != 0 || std::rename(temporary.c_str(), path.c_str()) != 0)) {
+			throw std::runtime_error("failed to replace " + path);
+		}
+	}
+
+private:
+	static constexpr std::size_t STRIPE_BITS = 8;
+	static constexpr std::size_t STRIPE_NUMBER = std::size_t(1) << STRIPE_BITS;
+
+	struct stripe_t {
+		mutable std::mutex lock;
+		FingerprintTable table;
+	};
+
+	std::array<stripe_t, STRIPE_NUMBER> _stripes;
+	std::atomic<std::uint64_t> _size{ 0 };
+};
+
+/// <summary>
+///		<para> HyperLogLog sketch estimating the number of distinct fingerprints with 2^14 registers, about 0.8% error. </para>
+///		<para> Sketches are merged by taking the maximum of every register, so each thread can own one. </para>
+///	</summary>
+class HyperLogLog {
+public:
+	static constexpr std::size_t PRECISION = 14;
+	static constexpr std::size_t REGISTER_NUMBER = std::size_t(1) << PRECISION;
+
+	/// <summary> Default constructor, the sketch is empty. </summary>
+	HyperLogLog() : _registers(REGISTER_NUMBER, 0) {}
+
+	/// <summary> Adds the fingerprint. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="value"> The fingerprint. </param>
+	void add(const fingerprint_t value) {
+		// High bits select the register, the rank is the position of the first set bit in the others
+		auto rest = (value << PRECISION) | (std::uint64_t(1) << (PRECISION - 1));
+		std::uint8_t rank = 1;
+		for (; (rest >> 63) == 0; rest <<= 1) {
+			rank++;
+		}
+		auto& reg = _registers[value >> (64 - PRECISION)];
+		reg = std::max(reg, rank);
+	}
+
+	/// <summary> Merges the other sketch into this one. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="other"> The other sketch. </param>
+	void merge(const HyperLogLog& other) {
+		std::transform(_registers.cbegin(), _registers.cend(), other._registers.cbegin(), _registers.begin(), [](const std::uint8_t lhs, const std::uint8_t rhs) {
+			return std::max(lhs, rhs); });
+	}
+
+	/// <summary> Estimates the number of distinct fingerprints added. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> The estimated count. </returns>
+	double estimate() const {
+		const auto registers = static_cast<double>(REGISTER_NUMBER);
+		double sum = 0;
+		std::size_t zeros = 0;
+		for (const auto reg : _registers) {
+			sum += std::ldexp(1.0, -static_cast<int>(reg));
+			zeros += (reg == 0) ? 1 : 0;
+		}
+		const auto raw = 0.7213 / (1 + 1.079 / registers) * registers * registers / sum;
+		// Linear counting is more accurate for small cardinalities
+		return (raw <= 2.5 * registers && zeros != 0) ? registers * std::log(registers / zeros) : raw;
+	}
+
+private:
+	std::vector<std::uint8_t> _registers;
+};
+
+/// <summary> Approximate set of fingerprints, a false positive reports a unique fingerprint as duplicated. </summary>
+class ApproximateSet {
+public:
+	virtual ~ApproximateSet() = default;
+
+	/// <summary> Inserts the fingerprint, thread-safe. </summary>
+	/// <param name="value"> The fingerprint. </param>
+	/// <returns> False if it was probably in the set before. </returns>
+	virtual bool insert(const fingerprint_t value) = 0;
+
+	/// <summary> Memory used by the filter in bytes. </summary>
+	virtual std::uint64_t memory() const = 0;
+
+	/// <summary> Number of fingerprints lost because the filter was full. </summary>
+	virtual std::uint64_t overflow() const = 0;
+
+	/// <summary> Bits of every stored tag. </summary>
+	virtual std::size_t tag_bits() const = 0;
+};
+
+/// <summary>
+///		<para> Cuckoo filter with 4 tags per bucket. </para>
+///		<para> The filter is split into independent segments selected by the high bits of fingerprint, both buckets </para>
+///		<para> of a tag are in the same segment, so inserts only lock one segment and rarely contend. </para>
+///	</summary>
+template <typename Tag>
+class CuckooFilter : public ApproximateSet {
+public:
+	static constexpr std::size_t BUCKET_SIZE = 4;
+	static constexpr std::size_t SEGMENT_BITS = 6;
+	static constexpr std::size_t SEGMENT_NUMBER = std::size_t(1) << SEGMENT_BITS;
+
+	/// <summary> Constructor. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="bucketNumber"> Number of buckets in each segment, must be a power of two. </param>
+	explicit CuckooFilter(const std::size_t bucketNumber) :
+		_bucketMask(bucketNumber - 1) {
+		for (auto& segment : _segments) {
+			segment.slots.assign(bucketNumber * BUCKET_SIZE, Tag(0));
+		}
+	}
+
+	bool insert(const fingerprint_t value) override {
+		constexpr std::size_t bits = sizeof(Tag) * 8;
+		auto& segment = _segments[value >> (64 - SEGMENT_BITS)];
+		auto tag = static_cast<Tag>(value >> (64 - SEGMENT_BITS - bits));
+		// Zero marks an empty slot
+		tag = (tag == 0) ? Tag(1) : tag;
+		const auto first = static_cast<std::size_t>(value) & _bucketMask;
+		const auto second = alternate(first, tag);
+
+		std::lock_guard<std::mutex> lock(segment.lock);
+		if (contains(segment, first, tag) || contains(segment, second, tag)) {
+			return false;
+		}
+		if (place(segment, first, tag) || place(segment, second, tag)) {
+			return true;
+		}
+		// Kick a random tag to its alternate bucket until one finds an empty slot
+		auto bucket = (segment.random & 1) ? first : second;
+		for (std::size_t kick = 0; kick < MAXIMUM_KICKS; kick++) {
+			segment.random = segment.random * 6364136223846793005ULL + 1442695040888963407ULL;
+			std::swap(tag, segment.slots[bucket * BUCKET_SIZE + (segment.random >> 62)]);
+			bucket = alternate(bucket, tag);
+			if (place(segment, bucket, tag)) {
+				return true;
+			}
+		}
+		// The filter is full, the last kicked tag is lost
+		_overflow++;
+		return true;
+	}
+
+	std::uint64_t memory() const override { return SEGMENT_NUMBER * (_bucketMask + 1) * BUCKET_SIZE * sizeof(Tag); }
+
+	std::uint64_t overflow() const override { return _overflow; }
+
+	std::size_t tag_bits() const override { return sizeof(Tag) * 8; }
+
+private:
+	static constexpr std::size_t MAXIMUM_KICKS = 500;
+
+	struct segment_t {
+		std::mutex lock;
+		std::vector<Tag> slots;
+		std::uint64_t random{ 0x853C49E6748FEA9BULL };
+	};
+
+	/// <summary> Gets the alternate bucket, alternate(alternate(i, tag), tag) == i. </summary>
+	std::size_t alternate(const std::size_t bucket, const Tag tag) const {
+		return (bucket ^ static_cast<std::size_t>(tag * 0x5BD1E995ULL)) & _bucketMask;
+	}
+
+	/// <summary> Query if the bucket contains the tag. </summary>
+	static bool contains(const segment_t& segment, const std::size_t bucket, const Tag tag) {
+		const auto slots = &segment.slots[bucket * BUCKET_SIZE];
+		return slots[0] == tag || slots[1] == tag || slots[2] == tag || slots[3] == tag;
+	}
+
+	/// <summary> Places the tag into an empty slot of the bucket. </summary>
+	static bool place(segment_t& segment, const std::size_t bucket, const Tag tag) {
+		const auto slots = &segment.slots[bucket * BUCKET_SIZE];
+		for (std::size_t i = 0; i < BUCKET_SIZE; i++) {
+			if (slots[i] == 0) {
+				slots[i] = tag;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::size_t _bucketMask;
+	std::array<segment_t, SEGMENT_NUMBER> _segments;
+	std::atomic<std::uint64_t> _overflow{ 0 };
+};
+
+/// <summary>
+///		<para> Makes a cuckoo filter for the expected number of fingerprints. </para>
+///		<para> Tag width is the smallest of 8, 16 and 32 bits meeting the false positive rate, </para>
+///		<para> the number of buckets is reduced to fit the memory budget if required. </para>
+///	</summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="expected">			 Expected number of unique fingerprints. </param>
+/// <param name="falsePositiveRate"> The false positive rate. </param>
+/// <param name="memoryBudget">		 The memory budget in bytes. </param>
+/// <returns> The filter. </returns>
+inline std::unique_ptr<ApproximateSet> make_cuckoo_filter(const std::uint64_t expected, const double falsePositiveRate, const std::uint64_t memoryBudget) {
+	using filter_t = CuckooFilter<std::uint8_t>;
+	// False positive rate of a cuckoo filter is about 2 * BUCKET_SIZE / 2^bits
+	const auto requiredBits = std::log2(2.0 * filter_t::BUCKET_SIZE / std::max(falsePositiveRate, 1e-9));
+	const std::size_t tagBytes = (requiredBits <= 8) ? 1 : ((requiredBits <= 16) ? 2 : 4);
+
+	// About 95% load factor is reachable with 4 tags per bucket
+	const auto slotsPerSegment = static_cast<double>(expected) / 0.95 / filter_t::SEGMENT_NUMBER;
+	std::size_t bucketNumber = 1;
+	while (bucketNumber * filter_t::BUCKET_SIZE < slotsPerSegment && bucketNumber < (std::size_t(1) << 40)) {
+		bucketNumber <<= 1;
+	}
+	while (bucketNumber > 1 && bucketNumber * filter_t::BUCKET_SIZE * tagBytes * filter_t::SEGMENT_NUMBER > memoryBudget) {
+		bucketNumber >>= 1;
+	}
+
+	switch (tagBytes) {
+	case 1:
+		return std::unique_ptr<ApproximateSet>(new CuckooFilter<std::uint8_t>(bucketNumber));
+	case 2:
+		return std::unique_ptr<ApproximateSet>(new CuckooFilter<std::uint16_t>(bucketNumber));
+	default:
+		return std::unique_ptr<ApproximateSet>(new CuckooFilter<std::uint32_t>(bucketNumber));
+	}
+}
+}	// namespace bwt
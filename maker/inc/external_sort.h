@@ -0,0 +1,462 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include <mutex>
+#include <queue>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <radix_sort.h>
+
+namespace bwt {
+namespace detail {
+#ifdef __linux__
+/// <summary> Copies the rest of the input to the output inside the kernel, falls back to read and write across file systems. </summary>
+/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+inline bool copy_descriptor(const int input, const int output) {
+	while (true) {
+		const auto copied = ::copy_file_range(input, nullptr, output, nullptr, std::size_t(1) << 30, 0);
+		if (copied == 0) {
+			return true;
+		}
+		if (copied < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP) {
+				return false;
+			}
+			break;
+		}
+	}
+	// Both offsets are advanced by what was copied so far
+	std::vector<char> buffer(std::size_t(1) << 20);
+	while (true) {
+		const auto size = ::read(input, buffer.data(), buffer.size());
+		if (size < 0 && errno == EINTR) {
+			continue;
+		}
+		if (size <= 0) {
+			return size == 0;
+		}
+		for (ssize_t written = 0; written < size;) {
+			const auto result = ::write(output, buffer.data() + written, static_cast<std::size_t>(size - written));
+			if (result < 0 && errno != EINTR) {
+				return false;
+			}
+			written += result < 0 ? 0 : result;
+		}
+	}
+}
+#endif
+
+/// <summary>
+///		<para> Appends the part files to the output in order, each one is removed once it is appended in full. </para>
+///		<para> Parts are copied inside the kernel where it is supported, so their bytes do not pass through the process. </para>
+///	</summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <exception cref="std::runtime_error"> Thrown when a part can not be read or the output can not be written, the part is kept. </exception>
+/// <param name="output"> The output file path, it must exist. </param>
+/// <param name="parts">  The part file paths. </param>
+inline void append_parts(const std::string& output, const std::vector<std::string>& parts) {
+#ifdef __linux__
+	// Kernel copies do not accept an output opened for appending, so the offset is moved to the end instead
+	const auto descriptor = ::open(output.c_str(), O_WRONLY);
+	if (descriptor < 0 || ::lseek(descriptor, 0, SEEK_END) < 0) {
+		const auto error = "failed to open " + output + ": " + std::strerror(errno);
+		if (descriptor >= 0) {
+			::close(descriptor);
+		}
+		throw std::runtime_error(error);
+	}
+	for (const auto& part : parts) {
+		const auto input = ::open(part.c_str(), O_RDONLY);
+		const auto succeed = input >= 0 && copy_descriptor(input, descriptor);
+		const auto error = "failed to append " + part + " to " + output + ": " + std::strerror(errno);
+		if (input >= 0) {
+			::close(input);
+		}
+		if (!succeed) {
+			::close(descriptor);
+			throw std::runtime_error(error);
+		}
+		std::remove(part.c_str());
+	}
+	if (::close(descriptor) != 0) {
+		throw std::runtime_error("failed to write " + output + ": " + std::strerror(errno));
+	}
+#else
+	std::ofstream file(output, std::ofstream::binary | std::ofstream::app);
+	if (!file) {
+		throw std::runtime_error("failed to open " + output);
+	}
+	for (const auto& part : parts) {
+		{
+			std::ifstream input(part, std::ifstream::binary);
+			if (!input) {
+				throw std::runtime_error("failed to open " + part);
+			}
+			if (input.peek() != std::ifstream::traits_type::eof()) {
+				file << input.rdbuf();
+			}
+		}
+		if (!file.flush()) {
+			throw std::runtime_error("failed to append " + part + " to " + output);
+		}
+		std::remove(part.c_str());
+	}
+#endif
+}
+}	// namespace detail
+
+/// <summary>
+///		<para> External-memory sort and optional unique of line feed terminated candidates. </para>
+///		<para> Candidates are buffered up to the run size, then sorted, deduplicated and written as a run file. </para>
+///		<para> A run counts the index used to sort it too, so that a run being sorted takes about the run size in memory. </para>
+///		<para> Runs are merged in parallel, each thread owns a disjoint key range chosen from sampled run keys. </para>
+///		<para> If all candidates fit in one run, they are sorted in memory and written without any run file. </para>
+///	</summary>
+class ExternalSorter {
+public:
+	using progress_t = std::function<void(const std::uint64_t, const std::uint64_t)>;
+
+	/// <summary> Constructor. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="prefix">	    Path prefix of the temporary run files. </param>
+	/// <param name="runBytes">	    Size of a run in bytes with its sort index, memory is bounded by about (threads + 1) runs. </param>
+	/// <param name="threadNumber"> Number of merge threads. </param>
+	/// <param name="order">		The sort order. </param>
+	/// <param name="unique">		Whether duplicated lines are dropped. </param>
+	ExternalSorter(const std::string& prefix, const std::size_t runBytes, const std::size_t threadNumber,
+				   const sort_order_t order = sort_order_t::LEXICOGRAPHIC, const bool unique = true) :
+		_prefix(prefix),
+		_runBytes(std::max<std::size_t>(runBytes, 1)),
+		_threadNumber(std::max<std::size_t>(threadNumber, 1)),
+		_order(order),
+		_unique(unique) {}
+
+	/// <summary> Destructor, removes all temporary files left. </summary>
+	~ExternalSorter() {
+		std::for_each(_runs.cbegin(), _runs.cend(), [](const auto& run) { std::remove(run.path.c_str()); });
+	}
+
+	ExternalSorter(const ExternalSorter&) = delete;
+	ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+	/// <summary> Adds line feed terminated candidates, thread-safe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when a run file can not be written. </exception>
+	/// <param name="data">  The data. </param>
+	/// <param name="bytes"> The data size. </param>
+	void add(const char* data, const std::size_t bytes) {
+		std::string full;
+		{
+			std::lock_guard<std::mutex> lock(_bufferLock);
+			if (_buffer.capacity() == 0) {
+				// Growing by doubling would hold up to twice the run
+				_buffer.reserve(_runBytes);
+			}
+			_buffer.append(data, bytes);
+			_bufferLines += static_cast<std::size_t>(std::count(data, data + bytes, '\n'));
+			if (_buffer.size() + _bufferLines * SORT_INDEX_BYTES < _runBytes) {
+				return;
+			}
+			full.swap(_buffer);
+			_bufferLines = 0;
+		}
+		// Sort and write outside of the lock so that runs are produced in parallel
+		write_run(full);
+	}
+
+	/// <summary> Writes the buffered candidates as the last run. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the run file can not be written. </exception>
+	void flush() {
+		std::string last;
+		{
+			std::lock_guard<std::mutex> lock(_bufferLock);
+			last.swap(_buffer);
+			_bufferLines = 0;
+		}
+		if (!last.empty()) {
+			write_run(last);
+		}
+	}
+
+	/// <summary> Merges all runs into the output file. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when a file can not be read or written. </exception>
+	/// <param name="output">   The output file path. </param>
+	/// <param name="progress"> Invoked periodically with merged and total bytes. </param>
+	/// <returns> Number of lines written. </returns>
+	std::uint64_t finish(const std::string& output, const progress_t& progress) {
+		if (runs() == 0) {
+			return sort_in_memory(output);
+		}
+		flush();
+
+		// Choose splitters from sampled keys, each part is merged by its own thread
+		std::vector<std::string> keys;
+		std::for_each(_runs.cbegin(), _runs.cend(), [&](const auto& run) {
+			std::for_each(run.samples.cbegin(), run.samples.cend(), [&](const auto& sample) { keys.emplace_back(sample.second); }); });
+		std::sort(keys.begin(), keys.end(), [&](const std::string& lhs, const std::string& rhs) { return before(lhs, rhs); });
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+		const auto parts = std::max<std::size_t>(1, std::min(_threadNumber, keys.size()));
+		std::vector<std::string> splitters;
+		for (std::size_t i = 1; i < parts; i++) {
+			splitters.emplace_back(keys[i * keys.size() / parts]);
+		}
+		splitters.erase(std::unique(splitters.begin(), splitters.end()), splitters.end());
+
+		const auto totalBytes = std::accumulate(_runs.cbegin(), _runs.cend(), std::uint64_t(0), [](const std::uint64_t total, const auto& run) {
+			return total + run.bytes; });
+		_merged = 0;
+		// The first range is merged into the output directly, the others are appended to it in order
+		std::vector<std::future<std::uint64_t>> results;
+		std::vector<std::string> partPaths;
+		for (std::size_t i = 0; i <= splitters.size(); i++) {
+			const auto lower = (i == 0) ? nullptr : &splitters[i - 1];
+			const auto upper = (i == splitters.size()) ? nullptr : &splitters[i];
+			if (i > 0) {
+				partPaths.emplace_back(part_path(i));
+			}
+			results.emplace_back(std::async(std::launch::async, &ExternalSorter::merge_range, this, lower, upper, i == 0 ? output : part_path(i)));
+		}
+		for (auto& result : results) {
+			while (result.wait_for(std::chrono::seconds(1)) != std::future_status::ready) {
+				progress(_merged, totalBytes);
+			}
+		}
+		std::uint64_t lines = 0;
+		std::for_each(results.begin(), results.end(), [&](auto& result) { lines += result.get(); });
+		progress(totalBytes, totalBytes);
+
+		detail::append_parts(output, partPaths);
+		return lines;
+	}
+
+	/// <summary> Number of runs written. </summary>
+	std::size_t runs() const {
+		std::lock_guard<std::mutex> lock(_runsLock);
+		return _runs.size();
+	}
+
+private:
+	/// <summary> Bytes of the sort index per line, the line itself and the scratch line of radix sort. </summary>
+	static constexpr std::size_t SORT_INDEX_BYTES = 2 * sizeof(line_t);
+
+	/// <summary> Lines sampled from every run to build its sparse index. </summary>
+	static constexpr std::size_t SAMPLE_INTERVAL = 4096;
+
+	using run_t = struct {
+		std::string path;
+		std::uint64_t bytes;
+		std::vector<std::pair<std::uint64_t, std::string>> samples;	// Offset and key of every SAMPLE_INTERVAL-th line
+	};
+	using cursor_t = struct {
+		std::ifstream file;
+		std::string line;
+	};
+
+	/// <summary> Query if the left line goes first in the sort order. </summary>
+	bool before(const std::string& lhs, const std::string& rhs) const {
+		return line_less({ lhs.data(), lhs.size() }, { rhs.data(), rhs.size() }, _order);
+	}
+
+	/// <summary> Gets the path of the merged part. </summary>
+	std::string part_path(const std::size_t part) const { return _prefix + ".part" + std::to_string(part); }
+
+	/// <summary> Splits the buffer into lines, then sorts and deduplicates them if required. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="buffer">		The line feed terminated candidates. </param>
+	/// <param name="threadNumber"> Number of sort threads. </param>
+	/// <returns> The sorted lines pointing into the buffer. </returns>
+	std::vector<line_t> sort_lines(const std::string& buffer, const std::size_t threadNumber) const {
+		std::vector<line_t> lines;
+		lines.reserve(static_cast<std::size_t>(std::count(buffer.cbegin(), buffer.cend(), '\n')) + 1);
+		for (std::size_t begin = 0, end = 0; begin < buffer.size(); begin = end + 1) {
+			end = buffer.find('\n', begin);
+			end = (end == std::string::npos) ? buffer.size() : end;
+			lines.emplace_back(buffer.data() + begin, end - begin);
+		}
+		radix_sort(lines, _order, threadNumber);
+		if (_unique) {
+			lines.erase(std::unique(lines.begin(), lines.end(), &line_equal), lines.end());
+		}
+		return lines;
+	}
+
+	/// <summary> Sorts the buffered candidates with all threads and writes them to the output directly. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="output"> The output file path. </param>
+	/// <returns> Number of lines written. </returns>
+	std::uint64_t sort_in_memory(const std::string& output) {
+		std::string buffer;
+		{
+			std::lock_guard<std::mutex> lock(_bufferLock);
+			buffer.swap(_buffer);
+		}
+		const auto lines = sort_lines(buffer, _threadNumber);
+		std::ofstream file(output, std::ofstream::binary | std::ofstream::trunc);
+		if (!file) {
+			throw std::runtime_error("failed to open " + output);
+		}
+		std::for_each(lines.cbegin(), lines.cend(), [&](const line_t& line) {
+			file.write(line.first, static_cast<std::streamsize>(line.second));
+			file.put('\n'); });
+		if (!file) {
+			throw std::runtime_error("failed to write " + output);
+		}
+		return lines.size();
+	}
+
+	/// <summary> Sorts, deduplicates and writes the buffer as a run. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="buffer"> The line feed terminated candidates. </param>
+	void write_run(const std::string& buffer) {
+		const auto lines = sort_lines(buffer, 1);
+
+		run_t run{ _prefix + ".run" + std::to_string(_runIndex++), 0, {} };
+		std::ofstream file(run.path, std::ofstream::binary | std::ofstream::trunc);
+		if (!file) {
+			throw std::runtime_error("failed to open " + run.path);
+		}
+		for (std::size_t i = 0; i < lines.size(); i++) {
+			if (i % SAMPLE_INTERVAL == 0) {
+				run.samples.emplace_back(run.bytes, std::string(lines[i].first, lines[i].second));
+			}
+			file.write(lines[i].first, static_cast<std::streamsize>(lines[i].second));
+			file.put('\n');
+			run.bytes += lines[i].second + 1;
+		}
+		if (!file) {
+			throw std::runtime_error("failed to write " + run.path);
+		}
+		std::lock_guard<std::mutex> lock(_runsLock);
+		_runs.emplace_back(std::move(run));
+	}
+
+	/// <summary> Merges the lines in [lower, upper) of all runs into the part file, or into the output for the first range. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="lower"> The inclusive lower key, null for unbounded. </param>
+	/// <param name="upper"> The exclusive upper key, null for unbounded. </param>
+	/// <param name="path">  The part file path. </param>
+	/// <returns> Number of lines written. </returns>
+	std::uint64_t merge_range(const std::string* lower, const std::string* upper, const std::string path) {
+		std::vector<std::unique_ptr<cursor_t>> cursors;
+		for (const auto& run : _runs) {
+			std::unique_ptr<cursor_t> cursor(new cursor_t{ std::ifstream(run.path, std::ifstream::binary), std::string() });
+			if (!cursor->file) {
+				throw std::runtime_error("failed to open " + run.path);
+			}
+			// Seek to the last sampled line less than the lower key
+			std::uint64_t offset = 0;
+			for (const auto& sample : run.samples) {
+				if (lower == nullptr || !before(sample.second, *lower)) {
+					break;
+				}
+				offset = sample.first;
+			}
+			cursor->file.seekg(static_cast<std::streamoff>(offset));
+			bool valid = false;
+			while ((valid = static_cast<bool>(std::getline(cursor->file, cursor->line))) && lower != nullptr && before(cursor->line, *lower)) {}
+			if (valid && (upper == nullptr || before(cursor->line, *upper))) {
+				cursors.emplace_back(std::move(cursor));
+			}
+		}
+
+		const auto greater = [&](const std::size_t lhs, const std::size_t rhs) { return before(cursors[rhs]->line, cursors[lhs]->line); };
+		std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(greater)> heap(greater);
+		for (std::size_t i = 0; i < cursors.size(); i++) {
+			heap.push(i);
+		}
+
+		std::ofstream file(path, std::ofstream::binary | std::ofstream::trunc);
+		if (!file) {
+			throw std::runtime_error("failed to open " + path);
+		}
+		std::string last;
+		std::uint64_t lines = 0;
+		while (!heap.empty()) {
+			const auto index = heap.top();
+			heap.pop();
+			auto& cursor = *cursors[index];
+			// Adjacent duplicates across runs are dropped
+			if (!_unique || lines == 0 || cursor.line != last) {
+				file.write(cursor.line.data(), static_cast<std::streamsize>(cursor.line.size()));
+				file.put('\n');
+				last = cursor.line;
+				lines++;
+			}
+			_merged += cursor.line.size() + 1;
+			if (std::getline(cursor.file, cursor.line) && (upper == nullptr || before(cursor.line, *upper))) {
+				heap.push(index);
+			}
+		}
+		if (!file) {
+			throw std::runtime_error("failed to write " + path);
+		}
+		return lines;
+	}
+
+	std::string _prefix;
+	std::size_t _runBytes;
+	std::size_t _threadNumber;
+	sort_order_t _order;
+	bool _unique;
+	std::mutex _bufferLock;
+	std::string _buffer;
+	std::size_t _bufferLines{ 0 };
+	mutable std::mutex _runsLock;
+	std::vector<run_t> _runs;
+	std::atomic<std::size_t> _runIndex{ 0 };
+	std::atomic<std::uint64_t> _merged{ 0 };
+};
+}	// namespace bwt
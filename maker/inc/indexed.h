@@ -0,0 +1,385 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace bwt {
+/// <summary> Format of the output. </summary>
+enum class output_format_t {
+	TEXT,
+	INDEXED
+};
+
+/// <summary> Extension of the indexed candidate file. </summary>
+constexpr char INDEXED_EXTENSION[] = ".pmc";
+
+/// <summary> Magic number at the head and the tail of the indexed candidate file. </summary>
+constexpr char INDEXED_MAGIC[] = "PMCIDX01";
+
+/// <summary> Size of the magic number. </summary>
+constexpr std::size_t INDEXED_MAGIC_SIZE = 8;
+
+/// <summary> Size of the footer, five 64-bit fields followed by the magic number. </summary>
+constexpr std::size_t INDEXED_FOOTER_SIZE = 5 * 8 + INDEXED_MAGIC_SIZE;
+
+/// <summary> Size of an index entry, rank of the first record and offset of the block. </summary>
+constexpr std::size_t INDEXED_ENTRY_SIZE = 2 * 8;
+
+/// <summary> Records between restart points of front coding, a seek decodes at most this many records. </summary>
+constexpr std::uint32_t INDEXED_RESTART_INTERVAL = 16;
+
+namespace detail {
+/// <summary> Appends the little-endian fixed-size integer. </summary>
+inline void put_fixed(std::string& out, const std::uint64_t value, const std::size_t size) {
+	for (std::size_t i = 0; i < size; i++) {
+		out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+	}
+}
+
+/// <summary> Reads the little-endian fixed-size integer. </summary>
+inline std::uint64_t get_fixed(const char* data, const std::size_t size) {
+	std::uint64_t value = 0;
+	for (std::size_t i = 0; i < size; i++) {
+		value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+	}
+	return value;
+}
+
+/// <summary> Appends the variable-length integer, 7 bits per byte. </summary>
+inline void put_varint(std::string& out, std::uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+/// <summary> Reads the variable-length integer and advances the cursor. </summary>
+/// <exception cref="std::runtime_error"> Thrown when it is truncated. </exception>
+inline std::uint64_t get_varint(const char*& data, const char* end) {
+	std::uint64_t value = 0;
+	for (std::size_t shift = 0; shift < 64 && data < end; shift += 7) {
+		const auto byte = static_cast<unsigned char>(*data++);
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return value;
+		}
+	}
+	throw std::runtime_error("truncated record of indexed file");
+}
+}	// namespace detail
+
+/// <summary>
+///		<para> Encodes the buffer of newline-terminated candidates in place into a block of the indexed candidate file. </para>
+///		<para> The block holds the record count, offsets of restart points and front-coded records, </para>
+///		<para> every record keeps the length of the prefix shared with the previous one, and the rest of its bytes. </para>
+///	</summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="block"> [in,out] The buffer, replaced by the encoded block. </param>
+inline void encode_indexed_block(std::string& block) {
+	// Scratch buffers are reused by every block of the thread
+	static thread_local std::string payload;
+	static thread_local std::string encoded;
+	static thread_local std::vector<std::uint32_t> restarts;
+	payload.clear();
+	restarts.clear();
+	std::uint32_t records = 0;
+	const char* previous = nullptr;
+	std::size_t previousSize = 0;
+	for (std::size_t begin = 0; begin < block.size();) {
+		auto end = block.find('\n', begin);
+		end = end == std::string::npos ? block.size() : end;
+		const auto record = block.data() + begin;
+		const auto size = end - begin;
+		std::size_t shared = 0;
+		if (records % INDEXED_RESTART_INTERVAL == 0) {
+			restarts.push_back(static_cast<std::uint32_t>(payload.size()));
+		} else {
+			const auto limit = std::min(size, previousSize);
+			shared = static_cast<std::size_t>(std::mismatch(record, record + limit, previous).first - record);
+		}
+		detail::put_varint(payload, shared);
+		detail::put_varint(payload, size - shared);
+		payload.append(record + shared, size - shared);
+		previous = record;
+		previousSize = size;
+		records++;
+		begin = end + 1;
+	}
+	encoded.clear();
+	detail::put_fixed(encoded, records, 4);
+	detail::put_fixed(encoded, restarts.size(), 4);
+	for (const auto restart : restarts) {
+		detail::put_fixed(encoded, restart, 4);
+	}
+	encoded.append(payload);
+	block.swap(encoded);
+}
+
+/// <summary> Gets the number of records of the encoded block. </summary>
+/// <param name="block"> The encoded block. </param>
+/// <returns> The number of records. </returns>
+inline std::uint32_t indexed_block_records(const std::string& block) {
+	return block.size() < 4 ? 0 : static_cast<std::uint32_t>(detail::get_fixed(block.data(), 4));
+}
+
+/// <summary> Encodes the index of blocks, the metadata and the footer that close the indexed candidate file. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="index">    Rank of the first record and offset of every block. </param>
+/// <param name="records">  Number of records. </param>
+/// <param name="offset">   Offset where the index starts, after the last block. </param>
+/// <param name="metadata"> The metadata. </param>
+/// <returns> The bytes to append. </returns>
+inline std::string encode_indexed_trailer(const std::vector<std::pair<std::uint64_t, std::uint64_t>>& index, const std::uint64_t records,
+										  const std::uint64_t offset, const std::string& metadata) {
+	std::string trailer;
+	for (const auto& entry : index) {
+		detail::put_fixed(trailer, entry.first, 8);
+		detail::put_fixed(trailer, entry.second, 8);
+	}
+	trailer.append(metadata);
+	detail::put_fixed(trailer, offset, 8);
+	detail::put_fixed(trailer, index.size(), 8);
+	detail::put_fixed(trailer, records, 8);
+	detail::put_fixed(trailer, offset + index.size() * INDEXED_ENTRY_SIZE, 8);
+	detail::put_fixed(trailer, metadata.size(), 8);
+	trailer.append(INDEXED_MAGIC, INDEXED_MAGIC_SIZE);
+	return trailer;
+}
+
+/// <summary>
+///		<para> Reader of the indexed candidate file, the file is memory mapped. </para>
+///		<para> Candidate N is found by a binary search over ranks of the block index and decoding from the nearest restart point. </para>
+///	</summary>
+class IndexedReader {
+public:
+	/// <summary> Constructor, the file is mapped and its footer is validated. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the file can not be opened or is not an indexed candidate file. </exception>
+	/// <param name="path"> The file path. </param>
+	explicit IndexedReader(const std::string& path) : _path(path) {
+		map();
+		if (_size < INDEXED_MAGIC_SIZE + INDEXED_FOOTER_SIZE || std::memcmp(_data, INDEXED_MAGIC, INDEXED_MAGIC_SIZE) != 0 ||
+			std::memcmp(_data + _size - INDEXED_MAGIC_SIZE, INDEXED_MAGIC, INDEXED_MAGIC_SIZE) != 0) {
+			unmap();
+			throw std::runtime_error(path + " is not an indexed candidate file");
+		}
+		const auto footer = _data + _size - INDEXED_FOOTER_SIZE;
+		_indexOffset = detail::get_fixed(footer, 8);
+		_blocks = detail::get_fixed(footer + 8, 8);
+		_records = detail::get_fixed(footer + 16, 8);
+		const auto metadataOffset = detail::get_fixed(footer + 24, 8);
+		const auto metadataSize = detail::get_fixed(footer + 32, 8);
+		// Every section must lie between the head and the footer in order
+		if (_indexOffset < INDEXED_MAGIC_SIZE || _blocks > (_size - _indexOffset) / INDEXED_ENTRY_SIZE ||
+			metadataOffset != _indexOffset + _blocks * INDEXED_ENTRY_SIZE || metadataSize != _size - INDEXED_FOOTER_SIZE - metadataOffset) {
+			unmap();
+			throw std::runtime_error(path + " has a corrupted footer");
+		}
+		_metadata.assign(_data + metadataOffset, static_cast<std::size_t>(metadataSize));
+	}
+
+	/// <summary> Destructor, the file is unmapped. </summary>
+	~IndexedReader() {
+		unmap();
+	}
+
+	IndexedReader(const IndexedReader&) = delete;
+	IndexedReader& operator=(const IndexedReader&) = delete;
+
+	/// <summary> Number of records. </summary>
+	std::uint64_t size() const { return _records; }
+
+	/// <summary> Number of blocks. </summary>
+	std::uint64_t blocks() const { return _blocks; }
+
+	/// <summary> Gets the metadata written with the file. </summary>
+	const std::string& metadata() const { return _metadata; }
+
+	/// <summary> Gets the candidate of the rank. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::out_of_range">  Thrown when the rank is out of range. </exception>
+	/// <exception cref="std::runtime_error"> Thrown when the block is corrupted. </exception>
+	/// <param name="rank"> The rank, from 0. </param>
+	/// <returns> The candidate. </returns>
+	std::string at(const std::uint64_t rank) const {
+		if (rank >= _records) {
+			throw std::out_of_range("candidate " + std::to_string(rank) + " of " + std::to_string(_records));
+		}
+		// The last block whose first rank is not above the rank
+		std::uint64_t low = 0;
+		std::uint64_t high = _blocks;
+		while (high - low > 1) {
+			const auto middle = low + (high - low) / 2;
+			(first_rank(middle) <= rank ? low : high) = middle;
+		}
+		const auto position = rank - first_rank(low);
+		std::string candidate;
+		decode(low, static_cast<std::uint32_t>(position / INDEXED_RESTART_INTERVAL), static_cast<std::uint32_t>(position % INDEXED_RESTART_INTERVAL) + 1,
+			   [&](const std::string& record) { candidate = record; });
+		return candidate;
+	}
+
+	/// <summary> Calls the function with every candidate in order. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when a block is corrupted. </exception>
+	/// <param name="function"> The function called with the candidate. </param>
+	template<typename Function>
+	void for_each(Function&& function) const {
+		for (std::uint64_t block = 0; block < _blocks; block++) {
+			decode(block, 0, std::numeric_limits<std::uint32_t>::max(), function);
+		}
+	}
+
+private:
+	/// <summary> Gets the rank of the first record of the block. </summary>
+	std::uint64_t first_rank(const std::uint64_t block) const {
+		return detail::get_fixed(_data + _indexOffset + block * INDEXED_ENTRY_SIZE, 8);
+	}
+
+	/// <summary> Gets the offset of the block, the index offset for the block after the last one. </summary>
+	std::uint64_t block_offset(const std::uint64_t block) const {
+		return block < _blocks ? detail::get_fixed(_data + _indexOffset + block * INDEXED_ENTRY_SIZE + 8, 8) : _indexOffset;
+	}
+
+	/// <summary> Decodes records of the block from the restart point. </summary>
+	/// <exception cref="std::runtime_error"> Thrown when the block is corrupted. </exception>
+	/// <param name="block">    The block. </param>
+	/// <param name="restart">  The restart point. </param>
+	/// <param name="count">    Number of records to decode at most. </param>
+	/// <param name="function"> The function called with every decoded record. </param>
+	template<typename Function>
+	void decode(const std::uint64_t block, const std::uint32_t restart, std::uint32_t count, Function&& function) const {
+		const auto begin = block_offset(block);
+		const auto end = block_offset(block + 1);
+		if (begin > end || end > _indexOffset || end - begin < 8) {
+			throw std::runtime_error("corrupted block " + std::to_string(block) + " of " + _path);
+		}
+		const auto data = _data + begin;
+		const auto records = static_cast<std::uint32_t>(detail::get_fixed(data, 4));
+		const auto restarts = static_cast<std::uint32_t>(detail::get_fixed(data + 4, 4));
+		const auto payload = data + 8 + std::uint64_t(restarts) * 4;
+		if (payload > _data + end || restart >= restarts) {
+			throw std::runtime_error("corrupted block " + std::to_string(block) + " of " + _path);
+		}
+		const auto offset = detail::get_fixed(data + 8 + std::uint64_t(restart) * 4, 4);
+		const char* cursor = payload + offset;
+		const char* limit = _data + end;
+		count = std::min(count, records - restart * INDEXED_RESTART_INTERVAL);
+		std::string record;
+		for (std::uint32_t i = 0; i < count; i++) {
+			const auto shared = detail::get_varint(cursor, limit);
+			const auto size = detail::get_varint(cursor, limit);
+			if (shared > record.size() || size > static_cast<std::uint64_t>(limit - cursor)) {
+				throw std::runtime_error("corrupted block " + std::to_string(block) + " of " + _path);
+			}
+			record.resize(static_cast<std::size_t>(shared));
+			record.append(cursor, static_cast<std::size_t>(size));
+			cursor += size;
+			function(record);
+		}
+	}
+
+	/// <summary> Maps the whole file, it is read into memory where mapping is not supported. </summary>
+	/// <exception cref="std::runtime_error"> Thrown when the file can not be opened. </exception>
+	void map() {
+#ifdef _WIN32
+		std::ifstream file(_path, std::ifstream::binary);
+		if (!file) {
+			throw std::runtime_error("failed to open " + _path);
+		}
+		_content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		_data = _content.data();
+		_size = _content.size();
+#else
+		const auto descriptor = ::open(_path.c_str(), O_RDONLY);
+		struct stat status {};
+		if (descriptor < 0 || ::fstat(descriptor, &status) != 0) {
+			const auto error = std::string("failed to open ") + _path + ": " + std::strerror(errno);
+			if (descriptor >= 0) {
+				::close(descriptor);
+			}
+			throw std::runtime_error(error);
+		}
+		_size = static_cast<std::size_t>(status.st_size);
+		if (_size > 0) {
+			const auto address = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (address == MAP_FAILED) {
+				const auto error = std::string("failed to map ") + _path + ": " + std::strerror(errno);
+				::close(descriptor);
+				throw std::runtime_error(error);
+			}
+			_data = static_cast<const char*>(address);
+		}
+		// The mapping stays valid after the file is closed
+		::close(descriptor);
+#endif
+	}
+
+	/// <summary> Unmaps the file. </summary>
+	void unmap() {
+#ifndef _WIN32
+		if (_data != nullptr) {
+			::munmap(const_cast<char*>(_data), _size);
+		}
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+	std::string _path;
+	const char* _data{ nullptr };
+	std::size_t _size{ 0 };
+#ifdef _WIN32
+	std::string _content;
+#endif
+	std::uint64_t _indexOffset{ 0 };
+	std::uint64_t _blocks{ 0 };
+	std::uint64_t _records{ 0 };
+	std::string _metadata;
+};
+}	// namespace bwt
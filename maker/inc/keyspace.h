@@ -0,0 +1,364 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cstdint>
+#include <cstring>
+
+#include <limits>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include <dedupe.h>
+
+namespace bwt {
+using rank_t = std::uint64_t;
+
+/// <summary> How many ranks one worker takes from the keyspace at a time. </summary>
+constexpr rank_t KEYSPACE_CHUNK_SIZE = rank_t(1) << 16;
+
+/// <summary> Kind of a keyspace radix. </summary>
+enum class radix_kind_t {
+	SEGMENT,	// Digit indexes into a seed table, the entry is concatenated into the candidate
+	SEPARATOR,	// Digit indexes into a separator set, the entry is inserted between every two segments
+	AFFIX,		// Digit indexes into a seed table, the entry is prepended or appended by a mutator
+	VARIANT		// Digit selects a capitalize/transform variant of the composed candidate
+};
+
+/// <summary> One digit position of the keyspace. </summary>
+struct radix_t {
+	radix_kind_t kind;
+	std::shared_ptr<const std::vector<std::string>> table;
+	std::size_t size;
+	std::shared_ptr<const std::vector<polynomial_hash_t>> hashes;	// Hash of every entry, null if fingerprints are not composed
+};
+
+/// <summary>
+///		<para> Mixed radix keyspace of a single formation. </para>
+///		<para> Every rank in [0, size()) maps to exactly one candidate, the last radix runs fastest. </para>
+///	</summary>
+class Keyspace {
+public:
+	using string_array_t = std::vector<std::string>;
+	using digits_t = std::vector<std::size_t>;
+	using hash_array_t = std::vector<polynomial_hash_t>;
+
+	/// <summary> Computes the polynomial hash of every entry of the table. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="table"> The table. </param>
+	/// <returns> The hashes in table order. </returns>
+	static std::shared_ptr<const hash_array_t> hash_table(const string_array_t& table) {
+		auto hashes = std::make_shared<hash_array_t>();
+		hashes->reserve(table.size());
+		for (const auto& entry : table) {
+			hashes->emplace_back(polynomial_hash(entry.data(), entry.size()));
+		}
+		return hashes;
+	}
+
+	/// <summary> Appends a segment radix whose digits index into the seed table. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="table">  The seed table. </param>
+	/// <param name="hashes"> Hashes of the table from hash_table(), null if fingerprints are not composed. </param>
+	void add_segment(const std::shared_ptr<const string_array_t>& table, const std::shared_ptr<const hash_array_t>& hashes = nullptr) {
+		_radixes.push_back({ radix_kind_t::SEGMENT, table, table->size(), hashes });
+	}
+
+	/// <summary> Appends the separator radix, a keyspace has at most one separator set shared by all gaps. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="table">  The separator set. </param>
+	/// <param name="hashes"> Hashes of the set from hash_table(), null if fingerprints are not composed. </param>
+	void add_separator(const std::shared_ptr<const string_array_t>& table, const std::shared_ptr<const hash_array_t>& hashes = nullptr) {
+		_separator = _radixes.size();
+		_radixes.push_back({ radix_kind_t::SEPARATOR, table, table->size(), hashes });
+	}
+
+	/// <summary> Appends an affix radix whose digits index into the seed table. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="table"> The seed table. </param>
+	void add_affix(const std::shared_ptr<const string_array_t>& table) {
+		_radixes.push_back({ radix_kind_t::AFFIX, table, table->size(), nullptr });
+	}
+
+	/// <summary> Appends a variant radix. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="variantNumber"> Number of variants of every composed candidate. </param>
+	void add_variant(const std::size_t variantNumber) {
+		_radixes.push_back({ radix_kind_t::VARIANT, nullptr, variantNumber, nullptr });
+	}
+
+	/// <summary> Gets the number of radixes. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> The number of radixes. </returns>
+	std::size_t width() const { return _radixes.size(); }
+
+	/// <summary> Gets the radix at given position. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="position"> The position. </param>
+	/// <returns> The radix. </returns>
+	const radix_t& radix(const std::size_t position) const { return _radixes[position]; }
+
+	/// <summary> Total number of candidates in this keyspace. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::overflow_error"> Thrown when the keyspace does not fit in rank_t. </exception>
+	/// <returns> The keyspace size. </returns>
+	rank_t size() const {
+		if (_radixes.empty()) {
+			return 0;
+		}
+		rank_t total = 1;
+		for (const auto& radix : _radixes) {
+			if (radix.size == 0) {
+				return 0;
+			}
+			if (total > std::numeric_limits<rank_t>::max() / radix.size) {
+				throw std::overflow_error("keyspace size exceeds 64-bit rank");
+			}
+			total *= radix.size;
+		}
+		return total;
+	}
+
+	/// <summary> Decodes a rank into its digits. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="rank">   The rank, must be less than size(). </param>
+	/// <param name="digits"> [out] The digits. </param>
+	void decode(rank_t rank, digits_t& digits) const {
+		digits.resize(_radixes.size());
+		for (std::size_t i = _radixes.size(); i-- > 0;) {
+			digits[i] = static_cast<std::size_t>(rank % _radixes[i].size);
+			rank /= _radixes[i].size;
+		}
+	}
+
+	/// <summary> Advances the digits to the next rank like an odometer. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="digits"> [in,out] The digits. </param>
+	/// <returns> False if the digits wrapped around to rank 0. </returns>
+	bool next(digits_t& digits) const {
+		for (std::size_t i = _radixes.size(); i-- > 0;) {
+			if (++digits[i] < _radixes[i].size) {
+				return true;
+			}
+			digits[i] = 0;
+		}
+		return false;
+	}
+
+	/// <summary> Composes the candidate by concatenating all segments, variants are not applied. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="digits">    The digits. </param>
+	/// <param name="candidate"> [out] The candidate. </param>
+	void compose(const digits_t& digits, std::string& candidate) const {
+		const auto separator = (_separator < _radixes.size()) ? &(*_radixes[_separator].table)[digits[_separator]] : nullptr;
+		bool first = true;
+		candidate.clear();
+		for (std::size_t i = 0; i < _radixes.size(); i++) {
+			if (_radixes[i].kind == radix_kind_t::SEGMENT) {
+				if (!first && separator != nullptr) {
+					candidate += *separator;
+				}
+				candidate += (*_radixes[i].table)[digits[i]];
+				first = false;
+			}
+		}
+	}
+
+	/// <summary> Gets the length of the composed candidate without composing it. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="digits"> The digits. </param>
+	/// <returns> The length, the same as the one of compose(). </returns>
+	std::size_t length(const digits_t& digits) const {
+		const auto separator = (_separator < _radixes.size()) ? (*_radixes[_separator].table)[digits[_separator]].size() : 0;
+		std::size_t length = 0;
+		std::size_t segments = 0;
+		for (std::size_t i = 0; i < _radixes.size(); i++) {
+			if (_radixes[i].kind == radix_kind_t::SEGMENT) {
+				length += (*_radixes[i].table)[digits[i]].size();
+				segments++;
+			}
+		}
+		return length + (segments > 1 ? (segments - 1) * separator : 0);
+	}
+
+	/// <summary> Gets the total bytes of composed candidates of ranks in [begin, end), each one followed by a line feed. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="begin"> The first rank. </param>
+	/// <param name="end">   The rank after the last one. </param>
+	/// <returns> The bytes. </returns>
+	std::uint64_t bytes(const rank_t begin, const rank_t end) const {
+		digits_t digits;
+		decode(begin, digits);
+		std::uint64_t total = 0;
+		for (rank_t rank = begin; rank < end; rank++, next(digits)) {
+			total += length(digits) + 1;
+		}
+		return total;
+	}
+
+	/// <summary> Query if fingerprints of composed candidates can be computed by fingerprint(). </summary>
+	bool composable() const {
+		return std::all_of(_radixes.cbegin(), _radixes.cend(), [](const radix_t& radix) {
+			return radix.hashes != nullptr || (radix.kind != radix_kind_t::SEGMENT && radix.kind != radix_kind_t::SEPARATOR); });
+	}
+
+	/// <summary> Composes the fingerprint of the candidate from entry hashes, in O(segments) whatever the candidate length is. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="digits"> The digits, should be composable(). </param>
+	/// <returns> The same fingerprint as hashing the bytes of compose(). </returns>
+	fingerprint_t fingerprint(const digits_t& digits) const {
+		const auto separator = (_separator < _radixes.size()) ? &(*_radixes[_separator].hashes)[digits[_separator]] : nullptr;
+		polynomial_hash_t hash{ 0, 1 };
+		bool first = true;
+		for (std::size_t i = 0; i < _radixes.size(); i++) {
+			if (_radixes[i].kind == radix_kind_t::SEGMENT) {
+				if (!first && separator != nullptr) {
+					hash = hash_concat(hash, *separator);
+				}
+				hash = hash_concat(hash, (*_radixes[i].hashes)[digits[i]]);
+				first = false;
+			}
+		}
+		return bwt::fingerprint(hash);
+	}
+
+	/// <summary> Gets the digit of the first radix with given kind. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="digits"> The digits. </param>
+	/// <param name="kind">   The radix kind. </param>
+	/// <returns> The digit, 0 if there is no such radix. </returns>
+	std::size_t digit_of(const digits_t& digits, const radix_kind_t kind) const {
+		const auto position = first_of(kind);
+		return position < _radixes.size() ? digits[position] : 0;
+	}
+
+	/// <summary> Gets the position of the first radix with given kind. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="kind"> The radix kind. </param>
+	/// <returns> The position, width() if there is no such radix. </returns>
+	std::size_t first_of(const radix_kind_t kind) const {
+		for (std::size_t i = 0; i < _radixes.size(); i++) {
+			if (_radixes[i].kind == kind) {
+				return i;
+			}
+		}
+		return _radixes.size();
+	}
+
+private:
+	std::vector<radix_t> _radixes;
+	std::size_t _separator{ std::numeric_limits<std::size_t>::max() };
+};
+
+/// <summary>
+///		<para> Contiguous batch of candidates, every candidate is stored followed by a line feed. </para>
+///		<para> The underlying bytes can be serialized as is. </para>
+///	</summary>
+class CandidateBatch {
+public:
+	/// <summary> Reserves memory for the batch. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="candidates"> Expected number of candidates. </param>
+	/// <param name="bytes">	  Expected number of bytes. </param>
+	void reserve(const std::size_t candidates, const std::size_t bytes) {
+		_offsets.reserve(candidates);
+		_bytes.reserve(bytes);
+	}
+
+	/// <summary> Clears the batch, memory is kept for reuse. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	void clear() {
+		_offsets.clear();
+		_bytes.clear();
+	}
+
+	/// <summary> Appends a candidate. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="data">   The candidate data. </param>
+	/// <param name="length"> The candidate length. </param>
+	void push(const char* data, const std::size_t length) {
+		_offsets.push_back(_bytes.size());
+		_bytes.append(data, length);
+		_bytes.push_back('\n');
+	}
+
+	/// <summary> Appends a candidate. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="candidate"> The candidate. </param>
+	void push(const std::string& candidate) { push(candidate.data(), candidate.size()); }
+
+	/// <summary> Number of candidates in the batch. </summary>
+	std::size_t size() const { return _offsets.size(); }
+
+	/// <summary> Query if this batch is empty. </summary>
+	bool empty() const { return _offsets.empty(); }
+
+	/// <summary> Gets the data of candidate at given index, not null terminated. </summary>
+	const char* data(const std::size_t index) const { return _bytes.data() + _offsets[index]; }
+
+	/// <summary> Gets the length of candidate at given index, the line feed is not included. </summary>
+	std::size_t length(const std::size_t index) const {
+		const auto end = (index + 1 < _offsets.size()) ? _offsets[index + 1] : _bytes.size();
+		return end - _offsets[index] - 1;
+	}
+
+	/// <summary> Gets the serializable bytes. </summary>
+	const std::string& bytes() const { return _bytes; }
+
+	/// <summary> Removes the candidates that satisfy the predicate, the batch is compacted in place. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="predicate"> The predicate with (const char* data, std::size_t length). </param>
+	template <typename Predicate>
+	void remove_if(Predicate predicate) {
+		std::size_t kept = 0;
+		std::size_t written = 0;
+		for (std::size_t i = 0; i < _offsets.size(); i++) {
+			const auto begin = _offsets[i];
+			const auto length = this->length(i);
+			if (predicate(_bytes.data() + begin, length)) {
+				continue;
+			}
+			if (written != begin) {
+				std::memmove(&_bytes[written], _bytes.data() + begin, length + 1);
+			}
+			_offsets[kept++] = written;
+			written += length + 1;
+		}
+		_offsets.resize(kept);
+		_bytes.resize(written);
+	}
+
+private:
+	std::vector<std::size_t> _offsets;
+	std::string _bytes;
+};
+}	// namespace bwt
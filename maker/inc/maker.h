@@ -102,9 +102,16 @@ and users must comply to its license: https://github.com/fmtlib/fmt/blob/master/
 
 #include <ctime>
 #include <cctype>
+#include <cmath>
 
 #include <map>
+#include <set>
+#include <queue>
+#include <array>
 #include <mutex>
+#include <atomic>
+#include <future>
+#include <limits>
 #include <regex>
 #include <string>
 #include <vector>
@@ -113,11 +120,19 @@ and users must comply to its license: https://github.com/fmtlib/fmt/blob/master/
 #include <sstream>
 #include <iomanip>
 #include <fstream>
+#include <numeric>
 #include <iterator>
+#include <stdexcept>
 #include <algorithm>
 #include <functional>
 
 #include <json.h>
+#include <keyspace.h>
+#include <mutator.h>
+#include <utf8.h>
+#include <dedupe.h>
+#include <external_sort.h>
+#include <writer.h>
 #include <ThreadPool.h> 
 #include <spdlog/sinks/stdout_color_sinks.h>
 
@@ -127,13 +142,20 @@ constexpr const char* CONFIG = "config";
 constexpr const char* GENERATE_SEED = "generate_seed";
 constexpr const char* FILE_SEED = "file_seed";
 constexpr const char* GENERATE_RULE = "generate_rule";
+constexpr const char* ENCODING = "encoding";
+constexpr const char* ENCODING_UTF8 = "utf-8";
 constexpr const char* CAPITALIZE = "capitalize";
 constexpr const char* FORMATION = "formation";
 constexpr const char* CONTENT = "content";
 constexpr const char* KEEP_IN_ORDER = "keep_in_order";
+constexpr const char* PATTERN = "pattern";
+constexpr const char* SEPARATOR = "separator";
 constexpr const char* TRANSFORM = "transform";
 constexpr const char* ACTIVE = "active";
 constexpr const char* RULES = "rules";
+constexpr const char* MUTATOR = "mutator";
+constexpr const char* CHAIN = "chain";
+constexpr const char* MAXIMUM_LENGTH = "maximum_length";
 constexpr const char* GENERATE_FILTER = "generate_filter";
 constexpr const char* MINIMUM_LENGTH = "minimum_length";
 constexpr const char* OPTIONAL_FILTER = "optional";
@@ -148,14 +170,73 @@ constexpr const char* DIST_PATH = "./dist/";
 constexpr const char* CONFIG_PATH = "./config/";
 constexpr const char* GENERATE_PATH = "./generated/";
 
+/// <summary> Runtime options given from command line. </summary>
+struct MakerOption {
+	/// <summary> Only compute the keyspace size without generating. </summary>
+	bool countOnly{ false };
+	/// <summary> Compare fused and staged pipelines without serializing. </summary>
+	bool benchmark{ false };
+	/// <summary> Drop candidates whose fingerprint was already emitted. </summary>
+	bool dedupe{ false };
+	/// <summary> Drop duplicated candidates with a bounded-memory cuckoo filter, false positives drop unique ones. </summary>
+	bool dedupeApproximate{ false };
+	/// <summary> False positive rate of approximate dedupe. </summary>
+	double falsePositiveRate{ 0.001 };
+	/// <summary> Memory budget of approximate dedupe in MB. </summary>
+	std::size_t dedupeMemory{ 1024 };
+	/// <summary> Estimate distinct candidates with a HyperLogLog sketch. </summary>
+	bool estimate{ false };
+	/// <summary> Fingerprint file of candidates emitted by earlier runs, empty if none. </summary>
+	std::string historyPath;
+	/// <summary> Sort and deduplicate the output with bounded memory through temporary run files. </summary>
+	bool uniqueExternal{ false };
+	/// <summary> Sort the output, candidates are sorted in memory or through temporary run files if they exceed the run size. </summary>
+	bool sort{ false };
+	/// <summary> Order of sorted output. </summary>
+	sort_order_t sortOrder{ sort_order_t::LEXICOGRAPHIC };
+	/// <summary> Run size of external sort in MB. </summary>
+	std::size_t runSize{ 256 };
+	/// <summary> Directory of temporary run files. </summary>
+	std::string temporaryPath{ GENERATE_PATH };
+	/// <summary> Number of output shards written in parallel, each one by its own writer, 0 for a single output. </summary>
+	std::size_t shards{ 0 };
+	/// <summary> Write byte-identical output in parallel at offsets planned per chunk into a preallocated file. </summary>
+	bool deterministic{ false };
+	/// <summary> Stream the output in the order of chunks through a bounded reorder buffer. </summary>
+	bool ordered{ false };
+	/// <summary> Stream the output to the standard output instead of a file, logs go to the standard error. </summary>
+	bool toStdout{ false };
+	/// <summary> Compression of the output, blocks are compressed by the workers. </summary>
+	compression_t compression{ compression_t::NONE };
+	/// <summary> Write the output as an indexed candidate file of front-coded blocks instead of text. </summary>
+	bool indexed{ false };
+	/// <summary> Backend of output writers, io_uring falls back to write(2) where it is not supported. </summary>
+	io_backend_t backend{ io_backend_t::BUFFERED };
+	/// <summary> Open output files with O_DIRECT when they are written through io_uring. </summary>
+	bool direct{ false };
+	/// <summary> Compare write(2) and io_uring writers on the same job instead of generating once. </summary>
+	bool benchmarkWriter{ false };
+	/// <summary> Switch the output to the next file before it exceeds this many bytes, 0 for a single file. </summary>
+	std::uint64_t rotateBytes{ 0 };
+	/// <summary> Switch the output to the next file before it exceeds this many lines, 0 for a single file. </summary>
+	std::uint64_t rotateLines{ 0 };
+	/// <summary> Serve chunks of the output to clients of this address, unix:/path or tcp:host:port, instead of writing a file. </summary>
+	std::string serve;
+	/// <summary> Number of output partitions chosen by fingerprint, each one is deduplicated by its own set, 0 for a single output. </summary>
+	std::size_t partitions{ 0 };
+};
+
 
 class PasswordMaker {
 public:
 	/// <summary> Constructor. </summary>
 	/// <remarks> BlueWingTan, 2020/4/16. </remarks>
 	/// <param name="configFileName"> [in,out] Filename of the configuration file. </param>
-	PasswordMaker(const std::string& configFileName, const std::size_t threadNumber = std::thread::hardware_concurrency()) :
+	/// <param name="threadNumber">   Number of worker threads. </param>
+	/// <param name="option">		  Runtime options. </param>
+	PasswordMaker(const std::string& configFileName, const std::size_t threadNumber = std::thread::hardware_concurrency(), const MakerOption& option = MakerOption()) :
 		_configFileName(CONFIG_PATH + configFileName),
+		_option(option),
 		_threadPool(threadNumber) {
 		_workerLogger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] [id:%6t] %v");
 	}
@@ -174,48 +255,270 @@ public:
 		}
 
 		_mainLogger->info("Parsing configuration file to get generate formation.");
-		const auto& multipleFormations = get_generate_formation();
+		auto multipleFormations = get_generate_formation();
 		if (!check_generate_formation(multipleFormations)) {
 			return false;
 		}
 
-		std::vector<std::string> results;
+		_mainLogger->info("Loading seed tables and generate rules.");
+		if (!load_encoding() || !load_seed_tables(multipleFormations) || !load_generate_rule()) {
+			return false;
+		}
+
+		_mainLogger->info("Analyzing duplicates of {} formation(s).", multipleFormations.size());
+		if (!plan_formations(multipleFormations)) {
+			return false;
+		}
+
+		// Lexicographic output is enumerated directly if possible instead of sorting
+		const auto order = _option.sort ? _option.sortOrder : sort_order_t::LEXICOGRAPHIC;
+		_plan.sorted = (_option.sort || _option.uniqueExternal) && order == sort_order_t::LEXICOGRAPHIC && sort_formations(multipleFormations);
+
+		_mainLogger->info("Planning keyspace of {} formation(s).", multipleFormations.size());
+		std::vector<Keyspace> keyspaces;
+		rank_t totalSize = 0;
+		try {
+			for (const auto& singleFormation : multipleFormations) {
+				keyspaces.emplace_back(build_keyspace(singleFormation));
+				const auto size = keyspaces.back().size();
+				_mainLogger->info("Formation [{}] has {} candidate(s).", formation_name(singleFormation), size);
+				if (totalSize > std::numeric_limits<rank_t>::max() - size) {
+					throw std::overflow_error("total keyspace size exceeds 64-bit rank");
+				}
+				totalSize += size;
+			}
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to plan keyspace with {}.", ex.what());
+			return false;
+		}
+		_mainLogger->info("Keyspace has {} candidate(s) in total before filtering.", totalSize);
+
+		if (_option.countOnly) {
+			_mainLogger->info("Done.");
+			return true;
+		}
+
+		if (_option.benchmark) {
+			benchmark(keyspaces);
+			_mainLogger->info("Done.");
+			return true;
+		}
+
+		if (_option.benchmarkWriter) {
+			benchmark_writers(keyspaces);
+			_mainLogger->info("Done.");
+			return true;
+		}
 
 		_mainLogger->info("Getting serial file name.");
 		get_serial_file_name();
 
-		_mainLogger->info("Generating password with multiple thread, pool size are {}.", _threadPool.size());
-		for (const auto& singleFormation : multipleFormations) {
-			_mainLogger->info("Generating formation [{}].", std::accumulate(singleFormation.begin(), singleFormation.end(), std::string(""), [&](auto& lhs, const auto& rhs) {
-				return lhs.empty() ? rhs : lhs + " " + rhs; }));
-			results.clear();
-			results.reserve(estimate_capacity(singleFormation));
-			std::size_t currentIndex = 0;
-			for (const auto& formation : singleFormation) {
-				_mainLogger->info("Generating pattern [{}].", formation);
-				auto contents(get_seed_content(formation));
-				// Last loop turn to serial
-				_mainLogger->info("Initiating worker processor.");
-				map_to_processor(results, contents, (currentIndex++ == singleFormation.size() - 1));
+		std::uint64_t history = 0;
+		if (_option.dedupe || !_option.historyPath.empty()) {
+			_mainLogger->info("Deduplicating with concurrent fingerprint set.");
+			_dedupe.reset(new FingerprintSet());
+		}
+		if (!_option.historyPath.empty()) {
+			// Candidates emitted by earlier runs are already in the set, so they are suppressed as duplicates
+			try {
+				history = _dedupe->load(_option.historyPath);
+			} catch (const std::exception& ex) {
+				_mainLogger->critical("Failed to load history with {}.", ex.what());
+				return false;
+			}
+			_mainLogger->info("Loaded {} fingerprint(s) of earlier runs from history {}.", history, _option.historyPath);
+		}
+		if (_option.dedupeApproximate) {
+			// Every candidate of keyspace may be unique, it is the upper bound before filtering
+			_approximate = make_cuckoo_filter(totalSize, _option.falsePositiveRate, std::uint64_t(_option.dedupeMemory) << 20);
+			const auto capacity = _approximate->memory() * 8 / _approximate->tag_bits();
+			_mainLogger->info("Deduplicating with cuckoo filter of {:.2f} MB, {}-bit tags, false positive rate about {:.2e}.",
+							  _approximate->memory() / 1048576.0, _approximate->tag_bits(), 8.0 / std::pow(2.0, _approximate->tag_bits()));
+			if (capacity * 95 / 100 < totalSize) {
+				_mainLogger->warn("Cuckoo filter holds about {} of {} candidate(s) within memory budget, duplicates may leak once it is full.",
+								  capacity * 95 / 100, totalSize);
 			}
 		}
+		_plan.dedupe = _dedupe != nullptr || _approximate != nullptr;
+		if (_option.partitions > 0) {
+			_mainLogger->info("Partitioning output into {} file(s) by fingerprint, each one is deduplicated by its own set.", _option.partitions);
+			if (!open_partitions()) {
+				return false;
+			}
+		}
+		if (_option.estimate) {
+			_mainLogger->info("Estimating distinct candidates with HyperLogLog sketch.");
+			_estimator.reset(new HyperLogLog());
+		}
+		if ((_option.uniqueExternal || _option.sort) && !_plan.sorted) {
+			_mainLogger->info("Sorting {}with {} MB run(s) in {}.", _option.uniqueExternal ? "and deduplicating " : "", _option.runSize, _option.temporaryPath);
+			_externalSorter.reset(new ExternalSorter(_option.temporaryPath + "/" + _serialFileName, _option.runSize << 20, _threadPool.size(),
+													 _option.sort ? _option.sortOrder : sort_order_t::LEXICOGRAPHIC, _option.uniqueExternal));
+		}
 
-		_mainLogger->info("Appendding additional dictionary.");
-		append_additional_dictionary();
+		if (_externalSorter == nullptr && !_plan.sorted && !_plan.partition && !_option.deterministic) {
+			if (!open_writers()) {
+				return false;
+			}
+		}
+
+		if (_plan.sorted) {
+			if (!generate_sorted(keyspaces)) {
+				return false;
+			}
+		} else if (_option.deterministic) {
+			if (!generate_deterministic(keyspaces, multipleFormations)) {
+				return false;
+			}
+		} else {
+			_mainLogger->info("Generating password with multiple thread, pool size are {}.", _threadPool.size());
+			for (std::size_t i = 0; i < keyspaces.size() && !stopped_by_consumer(); i++) {
+				_mainLogger->info("Generating formation [{}].", formation_name(multipleFormations[i]));
+				map_to_processor(keyspaces[i]);
+			}
+
+			if (!stopped_by_consumer()) {
+				_mainLogger->info("Appendding additional dictionary.");
+				append_additional_dictionary(load_additional_dictionary());
+			}
+		}
+
+		if (_option.indexed && !_writers.empty()) {
+			_writers.front()->describe(indexed_metadata(multipleFormations, keyspaces));
+		}
+		if (!_writers.empty() && !close_writers()) {
+			return false;
+		}
+
+		if (_externalSorter != nullptr && !merge_external()) {
+			return false;
+		}
+
+		if (_plan.partition && !close_partitions()) {
+			return false;
+		}
+		if (_dedupe != nullptr) {
+			const auto unique = _dedupe->size() - history;
+			_mainLogger->info("Deduplicated {} unique candidate(s), suppressed {} duplicate(s), {:.2f} byte(s) per fingerprint.",
+							  unique, _duplicates.load(), _dedupe->size() > 0 ? static_cast<double>(_dedupe->memory()) / _dedupe->size() : 0.0);
+		}
+		if (_approximate != nullptr) {
+			_mainLogger->info("Approximately deduplicated, suppressed {} candidate(s), {} tag(s) lost when the filter was full.",
+							  _duplicates.load(), _approximate->overflow());
+		}
+		if (_estimator != nullptr) {
+			_mainLogger->info("Estimated {}.", estimate_summary());
+		}
+		if (!_option.historyPath.empty() && stopped_by_consumer()) {
+			// Fingerprints of candidates queued but never delivered would suppress them in every later run
+			_mainLogger->warn("Consumer stopped the run early, history {} is left unchanged.", _option.historyPath);
+		} else if (!_option.historyPath.empty()) {
+			try {
+				_dedupe->save(_option.historyPath);
+			} catch (const std::exception& ex) {
+				_mainLogger->critical("Failed to save history with {}.", ex.what());
+				return false;
+			}
+			_mainLogger->info("Saved {} fingerprint(s) to history {}.", _dedupe->size(), _option.historyPath);
+		}
 
 		_mainLogger->info("Done.");
 		return true;
 	}
 
-private:
-	std::mutex _serialLock;
-	std::string _serialFileName;
-	std::string _configFileName;
-	nlohmann::json _configuration;
-	std::shared_ptr<spdlog::logger> _mainLogger{ spdlog::stdout_color_mt("Main") };
-	std::shared_ptr<spdlog::logger> _workerLogger{ spdlog::stdout_color_mt("Worker") };
-	ThreadPool _threadPool;
+	/// <summary> Concatenates the shards listed in the manifest, in order, into the output file next to it. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="manifestPath"> The manifest path. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool concat(const std::string& manifestPath) {
+		try {
+			std::ifstream file(manifestPath);
+			const auto manifest = nlohmann::json::parse(file);
+			// Rotated files are listed while they are generated, the last one is not closed yet
+			if (!manifest.value("complete", true)) {
+				throw std::runtime_error("generation is not complete");
+			}
+			const auto directory = manifestPath.substr(0, manifestPath.find_last_of("/\\") + 1);
+			const auto outputPath = directory + manifest["output"].get<std::string>();
+			std::ofstream output(outputPath, std::ofstream::binary | std::ofstream::trunc);
+			std::uint64_t lines = 0;
+			std::uint64_t bytes = 0;
+			for (const auto& shard : manifest["shards"]) {
+				const auto shardPath = directory + shard["file"].get<std::string>();
+				std::ifstream input(shardPath, std::ifstream::binary | std::ifstream::ate);
+				// A shard of another size is truncated or from another run
+				if (!input || static_cast<std::uint64_t>(input.tellg()) != shard["bytes"].get<std::uint64_t>()) {
+					throw std::runtime_error(shardPath + " does not match the manifest");
+				}
+				input.seekg(0);
+				if (input.peek() != std::ifstream::traits_type::eof()) {
+					output << input.rdbuf();
+				}
+				lines += shard["lines"].get<std::uint64_t>();
+				bytes += shard["bytes"].get<std::uint64_t>();
+			}
+			if (!output.flush()) {
+				throw std::runtime_error("failed to write " + outputPath);
+			}
+			_mainLogger->info("Concatenated {} shard(s) of {} line(s) and {} byte(s) into {}.", manifest["shards"].size(), lines, bytes, outputPath);
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to concatenate shards of {} with {}.", manifestPath, ex.what());
+			return false;
+		}
+		return true;
+	}
 
+	/// <summary> Converts the indexed candidate file back to text, next to it with the extension of text. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="indexedPath"> The indexed candidate file path. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool convert(const std::string& indexedPath) {
+		const auto extension = indexedPath.rfind(INDEXED_EXTENSION);
+		const auto outputPath = (extension != std::string::npos && extension + std::strlen(INDEXED_EXTENSION) == indexedPath.size() ?
+								 indexedPath.substr(0, extension) : indexedPath) + ".txt";
+		try {
+			const IndexedReader reader(indexedPath);
+			std::ofstream output(outputPath, std::ofstream::binary | std::ofstream::trunc);
+			std::string buffer;
+			buffer.reserve(OUTPUT_BUFFER_SIZE + (OUTPUT_BUFFER_SIZE >> 2));
+			std::uint64_t bytes = 0;
+			reader.for_each([&](const std::string& candidate) {
+				buffer.append(candidate).push_back('\n');
+				if (buffer.size() >= OUTPUT_BUFFER_SIZE) {
+					output.write(buffer.data(), buffer.size());
+					bytes += buffer.size();
+					buffer.clear();
+				} });
+			output.write(buffer.data(), buffer.size());
+			bytes += buffer.size();
+			if (!output.flush()) {
+				throw std::runtime_error("failed to write " + outputPath);
+			}
+			_mainLogger->info("Converted {} candidate(s) of {} block(s) into {} byte(s) of {}.", reader.size(), reader.blocks(), bytes, outputPath);
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to convert {} with {}.", indexedPath, ex.what());
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary> Looks up the candidate of the rank in the indexed candidate file without scanning it. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="indexedPath"> The indexed candidate file path. </param>
+	/// <param name="rank">		   The rank, from 0. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool lookup(const std::string& indexedPath, const std::uint64_t rank) {
+		try {
+			const IndexedReader reader(indexedPath);
+			_mainLogger->info("Candidate {} of {} is {}.", rank, reader.size(), reader.at(rank));
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to look up candidate {} of {} with {}.", rank, indexedPath, ex.what());
+			return false;
+		}
+		return true;
+	}
+
+private:
 	using attribure_t = struct {
 		bool optNumber;
 		bool optLowerLetter;
@@ -223,77 +526,417 @@ private:
 		bool optSpecialLetter;
 		std::size_t achiveOptional;
 		std::size_t minimumLength;
+		std::array<bool, 256> specialLetters;
+		std::vector<std::uint32_t> specialCodePoints;	// Sorted non-ASCII special letters in UTF-8 mode
+	};
+	using variant_t = struct {
+		bool capitalize;
+		bool transform;
 	};
 	using string_array_t = std::vector<std::string>;
+	using seed_table_t = std::shared_ptr<const string_array_t>;
+	using plan_t = struct {
+		bool variant;		// Capitalize or transform is required
+		bool mutate;		// Mutator chain is not empty
+		bool filter;		// Any filter rule may reject a candidate
+		bool dedupe;		// Exact or approximate dedupe is active
+		bool fused;			// Run every stage per candidate instead of per batch
+		bool sorted;		// Formations are enumerated in lexicographic order and merged
+		bool partition;		// Candidates are deduplicated and serialized by their hash partition
+	};
+	using sorted_source_t = struct {
+		const Keyspace* keyspace;		// Keyspace enumerated in lexicographic order, null for the dictionary
+		const string_array_t* entries;	// Sorted additional dictionary
+		rank_t size;
+	};
+	using sorted_cursor_t = struct {
+		const sorted_source_t* source;
+		rank_t rank;
+		rank_t end;
+		Keyspace::digits_t digits;
+		std::string candidate;
+	};
+	using partition_t = struct {
+		std::mutex lock;					// Held by the only writer of the partition
+		FingerprintTable fingerprints;
+		std::ofstream file;
+		rank_t written;
+	};
+	using partition_batch_t = struct {
+		CandidateBatch candidates;
+		std::vector<fingerprint_t> fingerprints;
+	};
+	using formation_t = struct {
+		string_array_t segments;
+		std::string separatorSeed;		// Seed name of the separator set, empty if none or literal
+		seed_table_t separators;		// Separator set inserted between segments, null if none
+		std::vector<seed_table_t> tables;	// Seed table of every segment, entries may be removed by the planner
+	};
+
+	std::unique_ptr<ChunkServer> _server;
+	std::vector<std::unique_ptr<OutputWriter>> _writers;
+	std::mutex _manifestLock;
+	nlohmann::json _rotatedFiles;
+	std::atomic<std::size_t> _nextWriter{ 0 };
+	std::unique_ptr<PositionalWriter> _positional;
+	rank_t _sequenceBase{ 0 };
+	std::vector<std::uint64_t> _chunkOffsets;
+	std::string _serialFileName;
+	std::string _configFileName;
+	nlohmann::json _configuration;
+	MakerOption _option;
+	std::map<std::string, seed_table_t> _seedTables;
+	std::map<seed_table_t, std::shared_ptr<const Keyspace::hash_array_t>> _seedHashes;
+	std::vector<variant_t> _variants;
+	std::vector<std::pair<std::string, std::string>> _transformRules;
+	MutatorChain _mutatorChain;
+	bool _utf8{ false };
+	attribure_t _attributes{};
+	plan_t _plan{ false, false, false, false, true, false, false };
+	std::atomic<rank_t> _nextChunk{ 0 };
+	std::unique_ptr<FingerprintSet> _dedupe;
+	std::vector<std::unique_ptr<partition_t>> _partitions;
+	std::unique_ptr<ApproximateSet> _approximate;
+	std::mutex _estimatorLock;
+	std::unique_ptr<HyperLogLog> _estimator;
+	std::atomic<rank_t> _estimated{ 0 };
+	std::unique_ptr<ExternalSorter> _externalSorter;
+	std::atomic<rank_t> _duplicates{ 0 };
+	std::shared_ptr<spdlog::logger> _mainLogger{ _option.toStdout ? spdlog::stderr_color_mt("Main") : spdlog::stdout_color_mt("Main") };
+	std::shared_ptr<spdlog::logger> _workerLogger{ _option.toStdout ? spdlog::stderr_color_mt("Worker") : spdlog::stdout_color_mt("Worker") };
+	ThreadPool _threadPool;
 
 private:
 
-	/// <summary> Processor. </summary>
+	/// <summary> Processor, takes chunks of the keyspace until it is exhausted. </summary>
 	/// <remarks> BlueWingTan, 2020/4/21. </remarks>
-	/// <param name="base">		    [in,out] The base. </param>
-	/// <param name="addon">	    The addon. </param>
+	/// <param name="keyspace">    The keyspace. </param>
+	/// <param name="chunkNumber">  Number of chunks in the keyspace. </param>
 	/// <param name="shouldSerial"> True if should serial. </param>
 	/// <returns> True if it succeeds, false if it fails. </returns>
-	bool processor(string_array_t& base, const string_array_t& addon, const bool shouldSerial) {
-		_workerLogger->info("Processing with base size {} and addon size {}.", base.size(), addon.size());
-		auto generated(password_generate(base, addon));
-		if (shouldSerial) {
-			password_capitalize(generated);
-			password_transform(generated);
-			password_filter(generated);
-			_workerLogger->info("Serializing generated password with size {}.", generated.size());
-			password_serial(generated);
-		}
-		replace_from_to(generated, base);
-		_workerLogger->info("Done.");
+	bool processor(const Keyspace& keyspace, const rank_t chunkNumber, const bool shouldSerial) {
+		const auto keyspaceSize = keyspace.size();
+		CandidateBatch batch;
+		std::vector<partition_batch_t> partitionBatches(_partitions.size());
+		// Batches are gathered into a large buffer before handed off to the writer
+		auto output = _writers.empty() ? std::string() : _writers.front()->acquire();
+		// Every processor owns its sketch, it is merged into the global one after each chunk
+		std::unique_ptr<HyperLogLog> sketch(_estimator != nullptr ? new HyperLogLog() : nullptr);
+		rank_t processed = 0;
+		rank_t serialized = 0;
+		for (rank_t chunk = _nextChunk++; chunk < chunkNumber; chunk = _nextChunk++) {
+			const auto begin = chunk * KEYSPACE_CHUNK_SIZE;
+			const auto end = std::min(begin + KEYSPACE_CHUNK_SIZE, keyspaceSize);
+			batch.clear();
+			if (_plan.partition) {
+				password_generate(keyspace, begin, end, batch, sketch.get(), &partitionBatches);
+			} else if (_plan.fused) {
+				password_generate(keyspace, begin, end, batch, sketch.get());
+			} else {
+				password_generate_staged(keyspace, begin, end, batch);
+			}
+			if (sketch != nullptr) {
+				std::lock_guard<std::mutex> lock(_estimatorLock);
+				_estimator->merge(*sketch);
+			}
+			processed += end - begin;
+			if (_positional != nullptr) {
+				serialized += batch.size();
+				if (shouldSerial && !password_serial_at(batch, chunk)) {
+					return false;
+				}
+				continue;
+			}
+			if (_plan.partition) {
+				serialized += password_serial(partitionBatches);
+				continue;
+			}
+			if (_option.ordered) {
+				serialized += batch.size();
+				if (shouldSerial && !password_serial_ordered(batch, _sequenceBase + chunk)) {
+					return false;
+				}
+				continue;
+			}
+			serialized += batch.size();
+			if (shouldSerial && !password_serial(batch, output)) {
+				return false;
+			}
+		}
+		if (shouldSerial && !_writers.empty() && !password_flush(output)) {
+			return false;
+		}
+		_workerLogger->info("Processed {} candidate(s) and serialized {}.", processed, serialized);
 		return true;
 	}
 
-	/// <summary> Multi processor. </summary>
+	/// <summary> Map the keyspace to processors in thread pool. </summary>
 	/// <remarks> BlueWingTan, 2020/4/21. </remarks>
-	/// <param name="base">		    [in,out] The base. </param>
-	/// <param name="addon">	    The addon. </param>
+	/// <param name="keyspace">		The keyspace. </param>
 	/// <param name="shouldSerial"> True if should serial. </param>
-	void multi_processor(string_array_t& base, const string_array_t& addon, const bool shouldSerial) {
-		const auto threadWokerNumber = _threadPool.size();
-		// Proceed the generated content
-		const auto properLoad = base.size() / threadWokerNumber;
-		const auto extraLoad = base.size() % threadWokerNumber;
-		auto currentIt = base.begin();
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool map_to_processor(const Keyspace& keyspace, const bool shouldSerial = true) {
+		const auto chunkNumber = (keyspace.size() + KEYSPACE_CHUNK_SIZE - 1) / KEYSPACE_CHUNK_SIZE;
+		// Never start more processors than chunks
+		const auto processorNumber = std::min<rank_t>(_threadPool.size(), chunkNumber);
 		std::vector<std::future<bool>> results;
-		std::vector<string_array_t> managed;
-		managed.reserve(threadWokerNumber);
-		results.reserve(threadWokerNumber);
-		for (size_t i = 0; i < threadWokerNumber - 1; i++, std::advance(currentIt, properLoad)) {
-			managed.emplace_back(string_array_t(currentIt, currentIt + properLoad));
-		}
-		managed.emplace_back(string_array_t(currentIt, currentIt + properLoad + extraLoad));
-		std::for_each(managed.begin(), managed.end(), [&](auto& generatedSlice) {
-			results.emplace_back(_threadPool.enqueue(&PasswordMaker::processor, this, std::ref(generatedSlice), std::cref(addon), shouldSerial)); });
-		// Wait future
-		std::for_each(results.begin(), results.end(), [](const auto& result) {result.wait(); });
-		// Replace already generated
-		replace_from_to(std::accumulate(managed.begin(), managed.end(), string_array_t(), [&](auto& lhs, auto& rhs) { std::copy(rhs.begin(), rhs.end(), std::back_inserter(lhs)); return lhs; }),
-						base);
-	}
-
-	/// <summary> Map to processor. </summary>
-	/// <remarks> BlueWingTan, 2020/4/21. </remarks>
-	/// <param name="alreadyGenerated"> [in,out] The already generated. </param>
-	/// <param name="formationContent"> The formation content. </param>
-	/// <param name="serialThisTurn">   True to serial this turn. </param>
-	void map_to_processor(string_array_t& alreadyGenerated, const string_array_t& formationContent, const bool serialThisTurn) {
-		const auto threadWokerNumber = _threadPool.size();
-		// Multiple thread optimization
-		// check alreadyGenerated and formationContent size
-		// if the size less than threadWokerNumber
-		// then should not start thread pool
-		if (alreadyGenerated.size() < threadWokerNumber && formationContent.size() < threadWokerNumber) {
-			// Single thread to process
-			processor(alreadyGenerated, formationContent, serialThisTurn);
-			return;
+		results.reserve(static_cast<std::size_t>(processorNumber));
+		_nextChunk = 0;
+		for (rank_t i = 0; i < processorNumber; i++) {
+			results.emplace_back(_threadPool.enqueue(&PasswordMaker::processor, this, std::cref(keyspace), chunkNumber, shouldSerial));
+		}
+		// Wait future, estimation is reported periodically if enabled
+		const auto succeed = std::accumulate(results.begin(), results.end(), true, [&](const bool succeed, auto& result) {
+			while (_estimator != nullptr && result.wait_for(std::chrono::seconds(1)) != std::future_status::ready) {
+				_mainLogger->info("Estimated {} so far.", estimate_summary());
+			}
+			return result.get() && succeed; });
+		// Sequence numbers of the next keyspace follow the chunks of this one
+		_sequenceBase += chunkNumber;
+		return succeed;
+	}
+
+	/// <summary> Formats the estimated distinct count and duplicate ratio. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> The summary. </returns>
+	std::string estimate_summary() {
+		double distinct = 0;
+		{
+			std::lock_guard<std::mutex> lock(_estimatorLock);
+			distinct = _estimator->estimate();
 		}
-		multi_processor(alreadyGenerated, formationContent, serialThisTurn);
+		const auto total = _estimated.load();
+		// The estimate may slightly exceed the number of candidates
+		distinct = std::min(distinct, static_cast<double>(total));
+		return fmt::format("{:.0f} distinct of {} candidate(s), duplicate ratio {:.2f}%", distinct, total, total > 0 ? 100.0 * (1 - distinct / total) : 0.0);
+	}
+
+	/// <summary> Benchmarks fused and staged pipelines on all keyspaces, nothing is serialized. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="keyspaces"> The keyspaces. </param>
+	void benchmark(const std::vector<Keyspace>& keyspaces) {
+		const auto fused = _plan.fused;
+		for (const auto pipeline : { false, true }) {
+			_plan.fused = pipeline;
+			const auto start = std::chrono::steady_clock::now();
+			std::for_each(keyspaces.cbegin(), keyspaces.cend(), [&](const auto& keyspace) { map_to_processor(keyspace, false); });
+			const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			const auto candidates = std::accumulate(keyspaces.cbegin(), keyspaces.cend(), rank_t(0), [](const rank_t total, const auto& keyspace) {
+				return total + keyspace.size(); });
+			_mainLogger->info("{} pipeline processed {} candidate(s) in {:.3f} s, {:.2f} M candidate(s)/s.", pipeline ? "Fused" : "Staged",
+							  candidates, elapsed, elapsed > 0 ? candidates / elapsed / 1e6 : 0.0);
+		}
+		_plan.fused = fused;
+	}
+
+	/// <summary> Benchmarks write(2) and io_uring writers on the same job, the output of every run is removed. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="keyspaces"> The keyspaces. </param>
+	void benchmark_writers(const std::vector<Keyspace>& keyspaces) {
+		const auto backend = _option.backend;
+		const auto dictionary = load_additional_dictionary();
+		for (const auto candidate : { io_backend_t::BUFFERED, io_backend_t::URING }) {
+			_option.backend = candidate;
+			_sequenceBase = 0;
+			get_serial_file_name();
+			if (!open_writers()) {
+				break;
+			}
+			const auto start = std::chrono::steady_clock::now();
+			std::for_each(keyspaces.cbegin(), keyspaces.cend(), [&](const auto& keyspace) { map_to_processor(keyspace); });
+			append_additional_dictionary(dictionary);
+			const auto name = _writers.front()->backend() == io_backend_t::URING ? (_writers.front()->direct() ? "io_uring O_DIRECT" : "io_uring") : "write(2)";
+			const auto closed = close_writers();
+			const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			const auto megabytes = std::accumulate(_writers.cbegin(), _writers.cend(), std::uint64_t(0), [](const std::uint64_t total, const auto& writer) {
+				return total + writer->bytes(); }) / 1048576.0;
+			std::for_each(_writers.cbegin(), _writers.cend(), [](const auto& writer) {
+				std::for_each(writer->files().cbegin(), writer->files().cend(), [](const auto& file) { std::remove(file.path.c_str()); }); });
+			_writers.clear();
+			if (!closed) {
+				break;
+			}
+			_mainLogger->info("{} writer generated {:.2f} MB in {:.3f} s, {:.2f} MB/s end to end.", name, megabytes, elapsed, elapsed > 0 ? megabytes / elapsed : 0.0);
+		}
+		_option.backend = backend;
+	}
+
+	/// <summary>
+	///		<para> Generates sorted output by merging lexicographically enumerated formations and the sorted dictionary. </para>
+	///		<para> Key ranges are chosen by sampling, each shard merges its own range of every source, </para>
+	///		<para> the first one into the output and the others into part files appended to it in order. </para>
+	///	</summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="keyspaces"> The keyspaces enumerated in lexicographic order. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool generate_sorted(const std::vector<Keyspace>& keyspaces) {
+		auto dictionary = load_additional_dictionary();
+		std::sort(dictionary.begin(), dictionary.end());
+		std::vector<sorted_source_t> sources;
+		std::for_each(keyspaces.cbegin(), keyspaces.cend(), [&](const auto& keyspace) { sources.push_back({ &keyspace, nullptr, keyspace.size() }); });
+		sources.push_back({ nullptr, &dictionary, dictionary.size() });
+
+		// Splitters are sampled evenly from the largest source
+		const auto& largest = *std::max_element(sources.cbegin(), sources.cend(), [](const auto& lhs, const auto& rhs) { return lhs.size < rhs.size; });
+		const auto shardNumber = std::max<std::size_t>(1, std::min<rank_t>(_threadPool.size(), largest.size));
+		string_array_t splitters;
+		Keyspace::digits_t digits;
+		for (std::size_t i = 1; i < shardNumber; i++) {
+			splitters.emplace_back();
+			candidate_at(largest, largest.size * i / shardNumber, digits, splitters.back());
+		}
+		splitters.erase(std::unique(splitters.begin(), splitters.end()), splitters.end());
+
+		_mainLogger->info("Enumerating {} formation(s) in lexicographic order, merged by {} shard(s).", keyspaces.size(), splitters.size() + 1);
+		// The first shard merges into the output directly, the others are appended to it in order
+		const auto output = GENERATE_PATH + _serialFileName;
+		std::vector<std::future<rank_t>> results;
+		std::vector<std::string> parts;
+		for (std::size_t shard = 0; shard <= splitters.size(); shard++) {
+			std::vector<std::pair<rank_t, rank_t>> ranges;
+			for (const auto& source : sources) {
+				ranges.emplace_back(shard == 0 ? 0 : lower_rank(source, splitters[shard - 1]),
+									shard == splitters.size() ? source.size : lower_rank(source, splitters[shard]));
+			}
+			if (shard > 0) {
+				parts.emplace_back(output + ".part" + std::to_string(shard));
+			}
+			results.emplace_back(_threadPool.enqueue(&PasswordMaker::merge_sorted_shard, this, std::cref(sources), ranges, shard == 0 ? output : parts.back()));
+		}
+
+		// Shards read the sources on this stack, every one must be done before it is left
+		std::for_each(results.begin(), results.end(), [](auto& result) { result.wait(); });
+		try {
+			rank_t written = 0;
+			std::for_each(results.begin(), results.end(), [&](auto& result) { written += result.get(); });
+			detail::append_parts(output, parts);
+			_mainLogger->info("Wrote {} sorted {}candidate(s).", written, _option.uniqueExternal ? "unique " : "");
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to merge sorted formations with {}.", ex.what());
+			std::for_each(parts.cbegin(), parts.cend(), [](const std::string& part) { std::remove(part.c_str()); });
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary> Gets the candidate at given rank of the sorted source. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="source">    The source. </param>
+	/// <param name="rank">	     The rank. </param>
+	/// <param name="digits">    [in,out] The digits buffer. </param>
+	/// <param name="candidate"> [out] The candidate. </param>
+	void candidate_at(const sorted_source_t& source, const rank_t rank, Keyspace::digits_t& digits, std::string& candidate) const {
+		if (source.keyspace != nullptr) {
+			source.keyspace->decode(rank, digits);
+			source.keyspace->compose(digits, candidate);
+		} else {
+			candidate = (*source.entries)[static_cast<std::size_t>(rank)];
+		}
+	}
+
+	/// <summary> Gets the first rank of the sorted source whose candidate is not less than the key. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="source"> The source. </param>
+	/// <param name="key">    The key. </param>
+	/// <returns> The rank, size of source if there is none. </returns>
+	rank_t lower_rank(const sorted_source_t& source, const std::string& key) const {
+		Keyspace::digits_t digits;
+		std::string candidate;
+		rank_t lower = 0;
+		rank_t upper = source.size;
+		while (lower < upper) {
+			const auto middle = lower + (upper - lower) / 2;
+			candidate_at(source, middle, digits, candidate);
+			if (candidate < key) {
+				lower = middle + 1;
+			} else {
+				upper = middle;
+			}
+		}
+		return lower;
+	}
+
+	/// <summary> Merges the rank ranges of all sorted sources into the part file, or into the output for the first shard. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the part file can not be written. </exception>
+	/// <param name="sources"> The sorted sources. </param>
+	/// <param name="ranges">  Rank range of every source. </param>
+	/// <param name="path">    The part file path. </param>
+	/// <returns> Number of candidates written. </returns>
+	rank_t merge_sorted_shard(const std::vector<sorted_source_t>& sources, const std::vector<std::pair<rank_t, rank_t>> ranges, const std::string path) {
+		// Advances the cursor to its next candidate, generated ones must pass the filter
+		const auto advance = [&](sorted_cursor_t& cursor) {
+			while (cursor.rank < cursor.end) {
+				if (cursor.source->keyspace == nullptr) {
+					cursor.candidate = (*cursor.source->entries)[static_cast<std::size_t>(cursor.rank++)];
+					return true;
+				}
+				cursor.source->keyspace->compose(cursor.digits, cursor.candidate);
+				cursor.source->keyspace->next(cursor.digits);
+				cursor.rank++;
+				if (!_plan.filter || password_has_achieved_attributes(cursor.candidate.data(), cursor.candidate.size(), _attributes)) {
+					return true;
+				}
+			}
+			return false;
+		};
+
+		std::vector<sorted_cursor_t> cursors;
+		for (std::size_t i = 0; i < sources.size(); i++) {
+			sorted_cursor_t cursor{ &sources[i], ranges[i].first, ranges[i].second, {}, {} };
+			if (cursor.rank < cursor.end && cursor.source->keyspace != nullptr) {
+				cursor.source->keyspace->decode(cursor.rank, cursor.digits);
+			}
+			if (advance(cursor)) {
+				cursors.emplace_back(std::move(cursor));
+			}
+		}
+		const auto greater = [&](const std::size_t lhs, const std::size_t rhs) { return cursors[rhs].candidate < cursors[lhs].candidate; };
+		std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(greater)> heap(greater);
+		for (std::size_t i = 0; i < cursors.size(); i++) {
+			heap.push(i);
+		}
+
+		std::ofstream file(path, std::ofstream::binary | std::ofstream::trunc);
+		CandidateBatch batch;
+		std::string last;
+		rank_t written = 0;
+		// Every shard owns its sketch, it is merged into the global one when the shard is done
+		std::unique_ptr<HyperLogLog> sketch(_estimator != nullptr ? new HyperLogLog() : nullptr);
+		std::uint64_t estimated = 0;
+		while (!heap.empty()) {
+			const auto index = heap.top();
+			heap.pop();
+			auto& cursor = cursors[index];
+			if (sketch != nullptr) {
+				sketch->add(fingerprint(cursor.candidate.data(), cursor.candidate.size()));
+				estimated++;
+			}
+			// Duplicates of a sorted stream are adjacent
+			if (!(_option.uniqueExternal && written != 0 && cursor.candidate == last) &&
+				(!_plan.dedupe || password_unique(cursor.candidate.data(), cursor.candidate.size()))) {
+				batch.push(cursor.candidate);
+				last = cursor.candidate;
+				written++;
+				if (batch.bytes().size() >= (std::size_t(1) << 20)) {
+					file.write(batch.bytes().data(), static_cast<std::streamsize>(batch.bytes().size()));
+					batch.clear();
+				}
+			}
+			if (advance(cursor)) {
+				heap.push(index);
+			}
+		}
+		file.write(batch.bytes().data(), static_cast<std::streamsize>(batch.bytes().size()));
+		if (sketch != nullptr) {
+			std::lock_guard<std::mutex> lock(_estimatorLock);
+			_estimator->merge(*sketch);
+			_estimated += estimated;
+		}
+		if (!file) {
+			throw std::runtime_error("failed to write " + path);
+		}
+		return written;
 	}
 
 	/// <summary> Loads the configuration. </summary>
@@ -324,64 +967,542 @@ private:
 	}
 
 	/// <summary>
-	///		<para> Serials the given contents, should be invoked after get_serial_file_name(). </para>
-	///		<para> This function is thread-safe by using std::lock_guard. </para>
+	///		<para> Serials the given contents, should be invoked after the writer or external sorter is created. </para>
+	///		<para> This function is thread-safe, the batch is handed off to the writer or external sorter. </para>
 	///	</summary>
 	/// <remarks> BlueWingTan, 2020/4/20. </remarks>
-	/// <param name="contents"> The contents. </param>
+	/// <param name="batch"> The candidate batch. </param>
 	/// <returns> True if it succeeds, false if it fails. </returns>
-	bool password_serial(const string_array_t& contents) {
-		// Make sure serial_safe_impl already returned
-		// to prevent early extract contents
-		std::lock_guard<std::mutex> lock(_serialLock);
-		std::fstream file(GENERATE_PATH + _serialFileName, std::fstream::app | std::fstream::out);
+	bool password_serial(const CandidateBatch& batch) {
+		if (batch.empty()) {
+			return true;
+		}
+		if (_externalSorter != nullptr) {
+			try {
+				_externalSorter->add(batch.bytes().data(), batch.bytes().size());
+			} catch (const std::exception& ex) {
+				_mainLogger->critical("Failed to write sorted run with {}.", ex.what());
+				return false;
+			}
+			return true;
+		}
+		if (_option.ordered) {
+			return password_serial_ordered(batch, _sequenceBase++);
+		}
+		auto output = batch.bytes();
+		return password_flush(output);
+	}
 
-		if (!file) {
-			_mainLogger->critical("Failed to open {} to serialize.", GENERATE_PATH + _serialFileName);
+	/// <summary> Serials the batch tagged with its sequence number, it is written after all batches of lower numbers. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="batch">    The candidate batch, may be empty. </param>
+	/// <param name="sequence"> The sequence number. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool password_serial_ordered(const CandidateBatch& batch, const rank_t sequence) {
+		auto output = batch.bytes();
+		try {
+			_writers.front()->push(output, sequence);
+		} catch (const std::exception& ex) {
+			if (!stopped_by_consumer()) {
+				_mainLogger->critical("Failed to serialize with {}.", ex.what());
+			}
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary> Serials the given contents through the output buffer of the worker, it is handed off to the writer once full. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="batch">  The candidate batch. </param>
+	/// <param name="output"> [in,out] The output buffer. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool password_serial(const CandidateBatch& batch, std::string& output) {
+		if (_writers.empty()) {
+			return password_serial(batch);
+		}
+		output += batch.bytes();
+		return output.size() < OUTPUT_BUFFER_SIZE || password_flush(output);
+	}
+
+	/// <summary> Hands off the output buffer to the next writer in turn, waits while its queue is full. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="output"> [in,out] The output buffer, replaced by an empty one. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool password_flush(std::string& output) {
+		try {
+			_writers[_nextWriter++ % _writers.size()]->push(output);
+		} catch (const std::exception& ex) {
+			if (!stopped_by_consumer()) {
+				_mainLogger->critical("Failed to serialize with {}.", ex.what());
+			}
 			return false;
+		}
+		return true;
+	}
+
+	/// <summary> Query if the consumer of the standard output closed it, generating stops quietly then. </summary>
+	bool stopped_by_consumer() const {
+		return std::any_of(_writers.cbegin(), _writers.cend(), [](const auto& writer) { return writer->broken(); });
+	}
+
+	/// <summary> Opens the writer of the output, or of every shard with their own files. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool open_writers() {
+		// Writers hold twice as many buffers as workers before they wait
+		const auto depth = std::max<std::size_t>(2, _threadPool.size() * 2 / std::max<std::size_t>(_option.shards, 1));
+		const auto extension = compression_extension(_option.compression);
+		if (!compression_available(_option.compression)) {
+			_mainLogger->critical("Compression of {} is not available, its library was not found when configuring.", extension);
+			return false;
+		}
+		if (_option.compression != compression_t::NONE) {
+			_mainLogger->info("Compressing blocks of the output into {} on workers.", extension);
+		}
+		try {
+			if (_option.toStdout) {
+				_writers.emplace_back(new OutputWriter(STDOUT_DESCRIPTOR, "stdout", depth, _option.compression));
+				_mainLogger->info("Streaming to stdout, {}.", _writers.back()->spliced() ? "pages are spliced into the pipe" : "buffers are written");
+				return true;
+			}
+			if (!_option.serve.empty()) {
+				// Chunks queue up to the depth of the writer, then workers wait for clients to ask for more
+				_server.reset(new ChunkServer(_option.serve, depth, [this](const served_client_t& client) { announce_client(client); }));
+				_writers.emplace_back(new OutputWriter(*_server, depth, _option.compression));
+				_mainLogger->info("Serving chunks on {}, generating runs as fast as clients ask for them.", _server->address());
+				return true;
+			}
+			WriterOption option;
+			option.compression = _option.compression;
+			option.backend = _option.backend;
+			option.direct = _option.direct;
+			option.rotateBytes = _option.rotateBytes;
+			option.rotateLines = _option.rotateLines;
+			option.rotated = [this](const output_file_t& file) { announce_rotated(file); };
+			if (rotating()) {
+				_rotatedFiles = nlohmann::json::array();
+				auto limit = _option.rotateBytes > 0 ? fmt::format("{} byte(s)", _option.rotateBytes) : std::string();
+				if (_option.rotateLines > 0) {
+					limit += (limit.empty() ? "" : " or ") + fmt::format("{} line(s)", _option.rotateLines);
+				}
+				_mainLogger->info("Rotating output files before {}, closed files are listed in {}.", limit, output_path(".manifest", ".json"));
+			}
+			if (_option.indexed) {
+				option.format = output_format_t::INDEXED;
+				_writers.emplace_back(new OutputWriter(output_path("", INDEXED_EXTENSION), depth, option));
+				_mainLogger->info("Encoding blocks of the output into indexed file {} on workers.", _writers.back()->path());
+			} else if (_option.shards == 0) {
+				_writers.emplace_back(new OutputWriter(GENERATE_PATH + _serialFileName + extension, depth, option));
+			} else {
+				_mainLogger->info("Writing {} shard(s) in parallel, each one by its own writer.", _option.shards);
+				for (std::size_t i = 0; i < _option.shards; i++) {
+					_writers.emplace_back(new OutputWriter(output_path(".part" + std::to_string(i), ".txt" + extension), depth, option));
+				}
+			}
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to open output with {}.", ex.what());
+			return false;
+		}
+		const auto& writer = _writers.front();
+		if (_option.backend == io_backend_t::URING && writer->backend() == io_backend_t::URING) {
+			_mainLogger->info("Writing through io_uring{}.", writer->direct() ? " with O_DIRECT" : "");
+		}
+		if (!writer->fallback().empty()) {
+			_mainLogger->warn("{}, falling back to {}.", writer->fallback(), writer->backend() == io_backend_t::URING ? "the page cache" : "write(2)");
+		}
+		return true;
+	}
+
+	/// <summary> Query if output files are rotated. </summary>
+	bool rotating() const {
+		return _option.rotateBytes > 0 || _option.rotateLines > 0;
+	}
+
+	/// <summary> Announces the file closed by rotation in the log and in the manifest, so that it may be consumed, thread-safe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="file"> The closed file. </param>
+	void announce_rotated(const output_file_t& file) {
+		std::lock_guard<std::mutex> lock(_manifestLock);
+		const auto name = file.path.substr(file.path.find_last_of("/\\") + 1);
+		_rotatedFiles.push_back({ { "file", name }, { "lines", file.lines }, { "bytes", file.bytes } });
+		_mainLogger->info("Closed {} of {} line(s) and {:.2f} MB, it is ready to consume.", file.path, file.lines, file.bytes / 1048576.0);
+		try {
+			write_manifest({ { "output", _serialFileName + compression_extension(_option.compression) }, { "complete", false }, { "shards", _rotatedFiles } });
+		} catch (const std::exception& ex) {
+			_mainLogger->warn("Failed to update manifest with {}.", ex.what());
+		}
+	}
+
+	/// <summary> Announces the client of the chunk server when it connects and when it leaves, thread-safe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="client"> The client. </param>
+	void announce_client(const served_client_t& client) {
+		if (client.connected) {
+			_mainLogger->info("Client {} connected from {}.", client.id, client.peer);
 		} else {
-			std::for_each(contents.cbegin(), contents.cend(), [&](auto& content) {file << content << std::endl; });
+			_mainLogger->info("Client {} {} after {} chunk(s) of {:.2f} MB.", client.id, client.finished ? "finished" : "disconnected",
+							  client.chunks, client.bytes / 1048576.0);
+		}
+	}
+
+	/// <summary> Writes the manifest of output files, it is replaced atomically so that readers never see a partial one. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when it can not be written. </exception>
+	/// <param name="manifest"> The manifest. </param>
+	void write_manifest(const nlohmann::json& manifest) const {
+		const auto path = output_path(".manifest", ".json");
+		{
+			std::ofstream file(path + ".tmp", std::ofstream::trunc);
+			file << manifest.dump(4) << std::endl;
+			if (!file) {
+				throw std::runtime_error("failed to write " + path + ".tmp");
+			}
+		}
+		// Renaming onto an existing file fails on Windows, only then it is removed first
+		if (std::rename((path + ".tmp").c_str(), path.c_str()) != 0 && (std::remove(path.c_str()) != 0 || std::rename((path + ".tmp").c_str(), path.c_str()) != 0)) {
+			throw std::runtime_error("failed to replace " + path);
+		}
+	}
+
+	/// <summary> Closes all writers after their buffers are written, reports the throughput and writes the manifest of shards. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool close_writers() {
+		std::uint64_t bytes = 0;
+		double elapsed = 0;
+		double busy = 0;
+		double waited = 0;
+		std::size_t reordered = 0;
+		nlohmann::json manifest{ { "output", _serialFileName + compression_extension(_option.compression) }, { "complete", true }, { "shards", nlohmann::json::array() } };
+		try {
+			for (const auto& writer : _writers) {
+				try {
+					writer->close();
+				} catch (const std::exception&) {
+					if (!writer->broken()) {
+						throw;
+					}
+					_mainLogger->info("Consumer closed {}, stopped after {:.2f} MB.", writer->path(), writer->bytes() / 1048576.0);
+				}
+				bytes += writer->bytes();
+				elapsed = std::max(elapsed, writer->elapsed());
+				busy = std::max(busy, writer->busy());
+				waited += writer->waited();
+				reordered = std::max(reordered, writer->reordered());
+				for (const auto& file : writer->files()) {
+					const auto name = file.path.substr(file.path.find_last_of("/\\") + 1);
+					manifest["shards"].push_back({ { "file", name }, { "lines", file.lines }, { "bytes", file.bytes } });
+				}
+				if (rotating()) {
+					const auto& last = writer->files().back();
+					_mainLogger->info("Closed {} of {} line(s) and {:.2f} MB, it is ready to consume.", last.path, last.lines, last.bytes / 1048576.0);
+				}
+			}
+			if (_server != nullptr) {
+				_mainLogger->info("Waiting for clients to take the last {} chunk(s).", _server->queued());
+				_server->close();
+				_mainLogger->info("Served {} chunk(s) of {:.2f} MB to {} client(s), generating waited {:.2f} s for them.",
+								  _server->chunks(), _server->bytes() / 1048576.0, _server->clients(), _server->waited());
+			}
+			if (_option.shards > 0 || rotating()) {
+				std::lock_guard<std::mutex> lock(_manifestLock);
+				write_manifest(manifest);
+				_mainLogger->info("Wrote manifest of {} file(s) to {}, concatenate them by --concat.", manifest["shards"].size(), output_path(".manifest", ".json"));
+			}
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to serialize with {}.", ex.what());
+			return false;
+		}
+		const auto megabytes = bytes / 1048576.0;
+		_mainLogger->info("Wrote {:.2f} MB in {:.2f} s, {:.2f} MB/s, writer busy {:.0f}%, workers waited {:.2f} s for it.",
+						  megabytes, elapsed, elapsed > 0 ? megabytes / elapsed : 0.0, elapsed > 0 ? 100.0 * busy / elapsed : 0.0, waited);
+		if (_option.ordered) {
+			_mainLogger->info("Released chunks in order, reorder buffer held at most {} chunk(s).", reordered);
+		}
+		if (_writers.front()->backend() == io_backend_t::URING) {
+			const auto stalls = std::accumulate(_writers.cbegin(), _writers.cend(), std::uint64_t(0), [](const std::uint64_t total, const auto& writer) {
+				return total + writer->stalls(); });
+			_mainLogger->info("io_uring writer waited for a free slot {} time(s).", stalls);
 		}
 		return true;
 	}
 
-	/// <summary> Replace from to. </summary>
-	/// <remarks> BlueWingTan, 2020/4/19. </remarks>
-	/// <param name="from"> Source for the. </param>
-	/// <param name="to">   [in,out] to. </param>
-	inline void replace_from_to(const string_array_t& from, string_array_t& to) const {
-		to.clear();	// In standard, clear() do not release underlying buffers
-		std::copy(from.cbegin(), from.cend(), std::back_inserter(to));
+	/// <summary>
+	///		<para> Generates byte-identical output regardless of thread scheduling. </para>
+	///		<para> Bytes of every chunk are planned first, then the file is preallocated and every chunk is written at its own offset. </para>
+	///	</summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="keyspaces">  The keyspaces. </param>
+	/// <param name="formations"> The formations of keyspaces. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool generate_deterministic(const std::vector<Keyspace>& keyspaces, const std::vector<formation_t>& formations) {
+		const auto dictionary = load_additional_dictionary();
+		std::vector<std::vector<std::uint64_t>> offsets;
+		std::uint64_t total = 0;
+		for (const auto& keyspace : keyspaces) {
+			offsets.emplace_back(plan_chunk_offsets(keyspace, total));
+			total = offsets.back().back();
+		}
+		const auto dictionaryBytes = std::accumulate(dictionary.cbegin(), dictionary.cend(), std::uint64_t(0), [](const std::uint64_t bytes, const auto& password) {
+			return bytes + password.size() + 1; });
+
+		_mainLogger->info("Planned {} byte(s) of output, preallocating {}.", total + dictionaryBytes, GENERATE_PATH + _serialFileName);
+		try {
+			_positional.reset(new PositionalWriter(GENERATE_PATH + _serialFileName, total + dictionaryBytes));
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to open output with {}.", ex.what());
+			return false;
+		}
+		_mainLogger->info("Generating password with multiple thread, pool size are {}.", _threadPool.size());
+		for (std::size_t i = 0; i < keyspaces.size(); i++) {
+			_mainLogger->info("Generating formation [{}].", formation_name(formations[i]));
+			_chunkOffsets = offsets[i];
+			if (!map_to_processor(keyspaces[i])) {
+				return false;
+			}
+		}
+		_mainLogger->info("Appendding additional dictionary.");
+		_chunkOffsets = { total, total + dictionaryBytes };
+		append_additional_dictionary(dictionary);
+
+		try {
+			_positional->close();
+			if (_positional->bytes() != total + dictionaryBytes) {
+				throw std::runtime_error(fmt::format("{} of {} planned byte(s) written", _positional->bytes(), total + dictionaryBytes));
+			}
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to serialize with {}.", ex.what());
+			return false;
+		}
+		const auto megabytes = _positional->bytes() / 1048576.0;
+		_mainLogger->info("Wrote {:.2f} MB deterministically in {:.2f} s, {:.2f} MB/s.",
+						  megabytes, _positional->elapsed(), _positional->elapsed() > 0 ? megabytes / _positional->elapsed() : 0.0);
+		return true;
 	}
 
-	/// <summary> Estimate total vector capacity. </summary>
-	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
+	/// <summary> Plans the output offset of every chunk of the keyspace in parallel. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="keyspace"> The keyspace. </param>
+	/// <param name="base">	    Offset of the first chunk. </param>
+	/// <returns> Offsets of all chunks followed by the end offset of the keyspace. </returns>
+	std::vector<std::uint64_t> plan_chunk_offsets(const Keyspace& keyspace, const std::uint64_t base) {
+		const auto keyspaceSize = keyspace.size();
+		const auto chunkNumber = (keyspaceSize + KEYSPACE_CHUNK_SIZE - 1) / KEYSPACE_CHUNK_SIZE;
+		// Lengths follow from the seed entries unless a stage may change or drop candidates, those chunks are generated to count them
+		const auto generated = _plan.mutate || _plan.filter || std::any_of(_variants.cbegin(), _variants.cend(), [&](const auto& variant) {
+			return variant.transform || (variant.capitalize && _utf8); });
+		std::vector<std::uint64_t> offsets(static_cast<std::size_t>(chunkNumber) + 1, 0);
+		std::atomic<rank_t> nextChunk{ 0 };
+		std::vector<std::future<void>> results;
+		for (rank_t i = 0; i < std::min<rank_t>(_threadPool.size(), chunkNumber); i++) {
+			results.emplace_back(_threadPool.enqueue([&]() {
+				CandidateBatch batch;
+				for (rank_t chunk = nextChunk++; chunk < chunkNumber; chunk = nextChunk++) {
+					const auto begin = chunk * KEYSPACE_CHUNK_SIZE;
+					const auto end = std::min(begin + KEYSPACE_CHUNK_SIZE, keyspaceSize);
+					if (generated) {
+						batch.clear();
+						password_generate(keyspace, begin, end, batch);
+						offsets[static_cast<std::size_t>(chunk) + 1] = batch.bytes().size();
+					} else {
+						offsets[static_cast<std::size_t>(chunk) + 1] = keyspace.bytes(begin, end);
+					}
+				} }));
+		}
+		std::for_each(results.begin(), results.end(), [](auto& result) { result.get(); });
+		offsets.front() = base;
+		std::partial_sum(offsets.cbegin(), offsets.cend(), offsets.begin());
+		return offsets;
+	}
+
+	/// <summary> Serials the batch of the chunk at its planned offset, thread-safe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="batch"> The candidate batch. </param>
+	/// <param name="chunk"> The chunk index. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool password_serial_at(const CandidateBatch& batch, const rank_t chunk) {
+		const auto offset = _chunkOffsets[static_cast<std::size_t>(chunk)];
+		const auto planned = _chunkOffsets[static_cast<std::size_t>(chunk) + 1] - offset;
+		try {
+			if (batch.bytes().size() != planned) {
+				throw std::runtime_error(fmt::format("{} byte(s) of chunk {} instead of the planned {}", batch.bytes().size(), chunk, planned));
+			}
+			_positional->write(batch.bytes().data(), batch.bytes().size(), offset);
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to serialize with {}.", ex.what());
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary> Gets the metadata of the indexed candidate file, formations and their candidates before filtering. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
 	/// <param name="formations"> The formations. </param>
-	/// <returns> Estimated capacity. </returns>
-	std::size_t estimate_capacity(const string_array_t& formations) const {
-		std::vector<std::size_t> estimateSize;
-		std::size_t singleFormationCapacity = 1;
+	/// <param name="keyspaces">  The keyspaces of formations. </param>
+	/// <returns> The metadata in JSON. </returns>
+	std::string indexed_metadata(const std::vector<formation_t>& formations, const std::vector<Keyspace>& keyspaces) const {
+		nlohmann::json metadata{ { "config", _configFileName }, { "output", _serialFileName }, { "formations", nlohmann::json::array() } };
+		for (std::size_t i = 0; i < formations.size(); i++) {
+			metadata["formations"].push_back({ { "name", formation_name(formations[i]) }, { "candidates", keyspaces[i].size() } });
+		}
+		return metadata.dump();
+	}
+
+	/// <summary> Gets the path of an output file derived from the serial file name. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="suffix">	 The suffix appended to the file name stem. </param>
+	/// <param name="extension"> The extension. </param>
+	/// <returns> The path. </returns>
+	std::string output_path(const std::string& suffix, const std::string& extension) const {
+		const auto stem = _serialFileName.substr(0, _serialFileName.rfind('.'));
+		return GENERATE_PATH + stem + suffix + extension;
+	}
+
+	/// <summary>
+	///		<para> Serials the partitioned batches, duplicates within each partition are dropped by its own set. </para>
+	///		<para> Equal candidates always fall into the same partition, so the union of partitions is duplicate-free. </para>
+	///	</summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="batches"> [in,out] The candidate batch of every partition, cleared after serialized. </param>
+	/// <returns> Number of candidates serialized. </returns>
+	rank_t password_serial(std::vector<partition_batch_t>& batches) {
+		rank_t serialized = 0;
+		for (std::size_t i = 0; i < batches.size(); i++) {
+			auto& batch = batches[i];
+			if (batch.fingerprints.empty()) {
+				continue;
+			}
+			auto& partition = *_partitions[i];
+			const auto candidates = batch.candidates.size();
+			{
+				std::lock_guard<std::mutex> lock(partition.lock);
+				std::size_t index = 0;
+				batch.candidates.remove_if([&](const char*, const std::size_t) { return !partition.fingerprints.insert(batch.fingerprints[index++]); });
+				partition.file.write(batch.candidates.bytes().data(), static_cast<std::streamsize>(batch.candidates.bytes().size()));
+				partition.written += batch.candidates.size();
+			}
+			_duplicates += candidates - batch.candidates.size();
+			serialized += batch.candidates.size();
+			batch.candidates.clear();
+			batch.fingerprints.clear();
+		}
+		return serialized;
+	}
+
+	/// <summary> Gets the partition of the fingerprint. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="value"> The fingerprint. </param>
+	/// <returns> The partition index. </returns>
+	std::size_t partition_of(const fingerprint_t value) const {
+		// High bits pick the partition, low bits index the table of the partition
+		return static_cast<std::size_t>(((value >> 32) * _partitions.size()) >> 32);
+	}
+
+	/// <summary> Gets the file path of the partition. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="index"> The partition index. </param>
+	/// <returns> The path. </returns>
+	std::string partition_path(const std::size_t index) const { return output_path(".partition" + std::to_string(index), ".txt"); }
+
+	/// <summary> Opens the files of all partitions, should be invoked after get_serial_file_name(). </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool open_partitions() {
+		for (std::size_t i = 0; i < _option.partitions; i++) {
+			_partitions.emplace_back(new partition_t());
+			_partitions.back()->file.open(partition_path(i), std::ofstream::binary | std::ofstream::trunc);
+			if (!_partitions.back()->file) {
+				_mainLogger->critical("Failed to open {} to serialize.", partition_path(i));
+				return false;
+			}
+		}
+		_plan.partition = true;
+		return true;
+	}
+
+	/// <summary> Closes the files of all partitions. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool close_partitions() {
+		rank_t written = 0;
+		std::uint64_t memory = 0;
+		auto smallest = std::numeric_limits<rank_t>::max();
+		rank_t largest = 0;
+		for (std::size_t i = 0; i < _partitions.size(); i++) {
+			auto& partition = *_partitions[i];
+			partition.file.close();
+			if (!partition.file) {
+				_mainLogger->critical("Failed to serialize {}.", partition_path(i));
+				return false;
+			}
+			written += partition.written;
+			memory += partition.fingerprints.memory();
+			smallest = std::min(smallest, partition.written);
+			largest = std::max(largest, partition.written);
+		}
+		_mainLogger->info("Wrote {} unique candidate(s) into {} partition(s) of {} to {}, suppressed {} duplicate(s), {:.2f} byte(s) per fingerprint.",
+						  written, _partitions.size(), smallest, largest, _duplicates.load(), written > 0 ? static_cast<double>(memory) / written : 0.0);
+		return true;
+	}
 
-		std::for_each(formations.cbegin(), formations.cend(), [&](const auto& content) {singleFormationCapacity *= get_seed_content(content).size(); });
-		estimateSize.emplace_back(singleFormationCapacity);
-		return *std::max_element(estimateSize.begin(), estimateSize.end());
+	/// <summary> Merges the sorted runs of external unique into the serial file. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool merge_external() {
+		try {
+			// Candidates within one run are sorted in memory without any run file
+			if (_externalSorter->runs() == 0) {
+				_mainLogger->info("Sorting candidates in memory into {}.", GENERATE_PATH + _serialFileName);
+			} else {
+				_externalSorter->flush();
+				_mainLogger->info("Merging {} sorted run(s) into {}.", _externalSorter->runs(), GENERATE_PATH + _serialFileName);
+			}
+			const auto lines = _externalSorter->finish(GENERATE_PATH + _serialFileName, [&](const std::uint64_t merged, const std::uint64_t total) {
+				_mainLogger->info("Merged {} of {} byte(s), {:.1f}%.", merged, total, total > 0 ? 100.0 * merged / total : 100.0); });
+			_mainLogger->info("Wrote {} sorted {}candidate(s).", lines, _option.uniqueExternal ? "unique " : "");
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to merge sorted runs with {}.", ex.what());
+			return false;
+		}
+		_externalSorter.reset();
+		return true;
 	}
 
+	/// <summary> Join the formation into a printable name. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="formation"> The formation. </param>
+	/// <returns> The formation name. </returns>
+	std::string formation_name(const formation_t& formation) const {
+		return std::accumulate(formation.segments.begin(), formation.segments.end(), std::string(""), [&](auto& lhs, const auto& rhs) {
+			return lhs.empty() ? rhs : lhs + " " + rhs; });
+	}
 	/// <summary> Gets generate formation. </summary>
 	/// <remarks> BlueWingTan, 2020/4/17. </remarks>
 	/// <returns> The generate formation. </returns>
-	std::vector<string_array_t> get_generate_formation() const {
-		std::vector<string_array_t> multipleFormations;
+	std::vector<formation_t> get_generate_formation() const {
+		std::vector<formation_t> multipleFormations;
 		try {
-			for (const auto& item : _configuration[CONFIG][GENERATE_RULE][FORMATION][CONTENT].get<string_array_t>()) {
+			for (const auto& item : _configuration[CONFIG][GENERATE_RULE][FORMATION][CONTENT]) {
+				// Content item is either a pattern or an object with pattern and separator
+				formation_t formation{ {}, "", nullptr, {} };
+				const auto& pattern = item.is_object() ? item[PATTERN].get<std::string>() : item.get<std::string>();
+				if (item.is_object() && item.find(SEPARATOR) != item.end()) {
+					if (item[SEPARATOR].is_string()) {
+						formation.separatorSeed = item[SEPARATOR].get<std::string>();
+					} else {
+						formation.separators = std::make_shared<const string_array_t>(item[SEPARATOR].get<string_array_t>());
+					}
+				}
+
 				// Tokenize the formation content
 				std::regex delimiter(R"(\s+)");
 				auto singleFormation = string_array_t(
-					std::sregex_token_iterator(item.cbegin(), item.cend(), delimiter, -1),
+					std::sregex_token_iterator(pattern.cbegin(), pattern.cend(), delimiter, -1),
 					std::sregex_token_iterator());
 
 				if (_configuration[CONFIG][GENERATE_RULE][FORMATION][KEEP_IN_ORDER].get<bool>()) {
-					multipleFormations.emplace_back(singleFormation);
+					formation.segments = singleFormation;
+					multipleFormations.emplace_back(formation);
 				} else {
 					// First we should arrange the formation
 					std::vector<string_array_t> permutation;
@@ -394,7 +1515,10 @@ private:
 					std::sort(permutation.begin(), permutation.end());
 					permutation.erase(std::unique(permutation.begin(), permutation.end()), permutation.end());
 
-					multipleFormations.insert(multipleFormations.end(), permutation.begin(), permutation.end());
+					// Separator set is shared by all permutations
+					std::for_each(permutation.begin(), permutation.end(), [&](auto& segments) {
+						formation.segments.swap(segments);
+						multipleFormations.emplace_back(formation); });
 				}
 			}
 		} catch (const std::exception& ex) {
@@ -408,7 +1532,7 @@ private:
 	/// <remarks> BlueWingTan, 2020/4/17. </remarks>
 	/// <param name="formations"> The formations. </param>
 	/// <returns> True if it succeeds, false if it fails. </returns>
-	bool check_generate_formation(const std::vector<string_array_t>& formations) const {
+	bool check_generate_formation(const std::vector<formation_t>& formations) const {
 		string_array_t legalSeeds;
 		try {
 			const auto& generateSeed = _configuration[CONFIG][GENERATE_SEED];
@@ -424,7 +1548,11 @@ private:
 			std::sort(legalSeeds.begin(), legalSeeds.end());
 			// Check if it is a subset
 			// Must deep copy to prevent change the origin vector
-			for (auto singleFormation : formations) {
+			for (const auto& formation : formations) {
+				auto singleFormation = formation.segments;
+				if (!formation.separatorSeed.empty()) {
+					singleFormation.emplace_back(formation.separatorSeed);
+				}
 				std::sort(singleFormation.begin(), singleFormation.end());
 				singleFormation.erase(std::unique(singleFormation.begin(), singleFormation.end()), singleFormation.end());
 				if (!std::includes(legalSeeds.begin(), legalSeeds.end(), singleFormation.begin(), singleFormation.end())) {
@@ -483,142 +1611,618 @@ private:
 		return contents;
 	}
 
-	/// <summary> Single password transformation by specified rules. </summary>
-	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
-	/// <param name="password"> The password. </param>
-	/// <param name="rules">    The rules. </param>
-	/// <returns> Transformed password. </returns>
-	std::string password_transform_single(const std::string& password, const std::map<std::string, std::string>& rules) const {
-		std::string replaced = password;
-		std::for_each(rules.cbegin(), rules.cend(), [&](const auto& rule) {std::regex_replace(replaced, std::regex(rule.first), rule.second); });
-		return replaced;
-	}
-
-	/// <summary> Transform password with specified rules, and insert into the original container. </summary>
-	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
-	/// <param name="passwords"> [in,out] The passwords. </param>
-	void password_transform(string_array_t& passwords) const {
+	/// <summary> Loads seed table of every segment used by the formations, each seed is loaded only once. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="formations"> [in,out] The formations, separator sets given by seed name are resolved. </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool load_seed_tables(std::vector<formation_t>& formations) {
+		_seedTables.clear();
 		try {
-			const auto& transformConfig = _configuration[CONFIG][GENERATE_RULE][TRANSFORM];
-			if (transformConfig[ACTIVE].get<bool>()) {
-				// Activated
-				const auto& rules = transformConfig[RULES].get<std::map<std::string, std::string>>();
-				string_array_t transformedPasswords;
-
-				std::for_each(passwords.begin(), passwords.end(), [&](const auto& password) {
-					auto transformed(password_transform_single(password, rules));
-					if (transformed != password) {
-						transformedPasswords.emplace_back(transformed);
-					}});
-				std::copy(passwords.begin(), passwords.end(), std::back_inserter(transformedPasswords));
+			for (auto& formation : formations) {
+				formation.tables.clear();
+				std::for_each(formation.segments.cbegin(), formation.segments.cend(), [&](const auto& segment) {
+					formation.tables.emplace_back(seed_table(segment)); });
+				if (!formation.separatorSeed.empty()) {
+					formation.separators = seed_table(formation.separatorSeed);
+				}
 			}
 		} catch (const std::exception& ex) {
-			_mainLogger->critical("Failed to parse configuration file for transforming passwords with {}.", ex.what());
+			_mainLogger->critical("Failed to load seed tables with {}.", ex.what());
+			return false;
 		}
+		return true;
 	}
 
-	/// <summary> Weather password has specified attribute defined in configuration. </summary>
-	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
-	/// <param name="password"> The password. </param>
-	/// <returns> True if it password has specified attribute, false otherwise. </returns>
-	bool password_has_achieved_attributes(const std::string& password, const attribure_t& attributes) const {
-		using filter_result_t = struct {
-			std::function<bool(std::string::value_type)> test;
-			bool supposed;
-			bool actual;
-		};
-
-		std::vector<filter_result_t> attributeTests{
-			{[&](std::string::value_type ch) { return std::islower(ch) != 0; }, attributes.optLowerLetter, false},
-			{[&](std::string::value_type ch) { return std::isupper(ch) != 0; }, attributes.optUpperLetter, false},
-			{[&](std::string::value_type ch) { return std::isdigit(ch) != 0; }, attributes.optNumber, false},
-			{[&](std::string::value_type ch) {
-				const auto& specialLetters = get_seed_content(SPECIAL_LETTER);
-				std::for_each(specialLetters.cbegin(), specialLetters.cend(),
-							  [&](const auto& letter) { if (letter.find(ch)) { return true; } return false; }); return false; },
-			attributes.optSpecialLetter, false }
-		};
-
-		// Now we check it
-		std::for_each(password.cbegin(), password.cend(), [&](const auto& ch) {
-			std::for_each(attributeTests.begin(), attributeTests.end(), [&](auto& result) {
-				if (!result.actual) { result.actual = result.test(ch); }}); });
+	/// <summary> Gets the seed table with given name, the table is loaded on first use. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::invalid_argument"> Thrown when the seed is not defined in configuration. </exception>
+	/// <param name="seedName"> Name of the seed. </param>
+	/// <returns> The seed table. </returns>
+	seed_table_t seed_table(const std::string& seedName) {
+		const auto cached = _seedTables.find(seedName);
+		if (cached != _seedTables.end()) {
+			return cached->second;
+		}
+		const auto& generateSeed = _configuration[CONFIG][GENERATE_SEED];
+		if (seedName == FILE_SEED || (generateSeed.find(seedName) == generateSeed.end() && generateSeed[FILE_SEED].find(seedName) == generateSeed[FILE_SEED].end())) {
+			throw std::invalid_argument("seed '" + seedName + "' is not in generate seeds");
+		}
+		auto contents(get_seed_content(seedName));
+		if (_utf8) {
+			normalize_seed(contents, seedName);
+		}
+		// Repeated entries always compose duplicated candidates, only the first one is kept
+		std::set<std::string> entries;
+		const auto size = contents.size();
+		contents.erase(std::remove_if(contents.begin(), contents.end(), [&](const auto& entry) { return !entries.insert(entry).second; }), contents.end());
+		if (contents.size() != size) {
+			_mainLogger->info("Removed {} repeated entries of seed {}.", size - contents.size(), seedName);
+		}
+		return _seedTables.emplace(seedName, std::make_shared<const string_array_t>(std::move(contents))).first->second;
+	}
 
-		// Meet the request
-		auto achievedOptional = std::accumulate(attributeTests.begin(), attributeTests.end(), std::size_t(0), [](const auto& meets, const auto& attribute) {
-			return meets + (attribute.supposed == attribute.actual); });
+	/// <summary> Loads the encoding of seeds, candidates are handled as UTF-8 code points instead of bytes if required. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool load_encoding() {
+		try {
+			const auto& generateRule = _configuration[CONFIG][GENERATE_RULE];
+			const auto encoding = generateRule.find(ENCODING);
+			_utf8 = (encoding != generateRule.end() && encoding->get<std::string>() == ENCODING_UTF8);
+		} catch (const std::exception& ex) {
+			_mainLogger->critical("Failed to parse configuration file for encoding with {}.", ex.what());
+			return false;
+		}
+		return true;
+	}
 
-		return ((achievedOptional >= attributes.achiveOptional) && (password.length() >= attributes.minimumLength));
+	/// <summary>
+	///		<para> Normalizes seed content to UTF-8, byte order mark and carriage return are removed. </para>
+	///		<para> Entries failed to pass UTF-8 validation are decoded as ISO-8859-1. </para>
+	///	</summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="contents"> [in,out] The seed content. </param>
+	/// <param name="seedName"> Name of the seed. </param>
+	void normalize_seed(string_array_t& contents, const std::string& seedName) const {
+		std::size_t transcoded = 0;
+		if (!contents.empty() && contents.front().compare(0, 3, utf8::BOM) == 0) {
+			contents.front().erase(0, 3);
+		}
+		for (auto& content : contents) {
+			if (!content.empty() && content.back() == '\r') {
+				content.pop_back();
+			}
+			if (!utf8::validate(content)) {
+				content = utf8::from_latin1(content);
+				transcoded++;
+			}
+		}
+		if (transcoded != 0) {
+			_mainLogger->warn("{} entries of seed {} are not valid UTF-8 and decoded as ISO-8859-1.", transcoded, seedName);
+		}
 	}
 
-	/// <summary> Password attributeConfig. </summary>
-	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
-	/// <param name="passwords"> [in, out] The passwords. </param>
-	void password_filter(string_array_t& passwords) const {
+	/// <summary> Loads capitalize, transform, mutator and filter rules from configuration. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool load_generate_rule() {
 		try {
+			const auto& generateRule = _configuration[CONFIG][GENERATE_RULE];
+			const auto capitalize = generateRule[CAPITALIZE].get<bool>();
+			// Every composed candidate is emitted once per variant
+			_variants = { { capitalize, false } };
+			_transformRules.clear();
+			if (generateRule[TRANSFORM][ACTIVE].get<bool>()) {
+				const auto& rules = generateRule[TRANSFORM][RULES].get<std::map<std::string, std::string>>();
+				std::copy_if(rules.cbegin(), rules.cend(), std::back_inserter(_transformRules), [](const auto& rule) {
+					return !rule.first.empty(); });
+				_variants.push_back({ capitalize, true });
+			}
+
+			const auto mutator = generateRule.find(MUTATOR);
+			_mutatorChain = MutatorChain();
+			if (mutator != generateRule.end() && (*mutator)[ACTIVE].get<bool>()) {
+				_mutatorChain = MutatorChain((*mutator)[CHAIN].get<string_array_t>(), (*mutator)[MAXIMUM_LENGTH].get<std::size_t>(),
+											 [&](const std::string& seedName) { return seed_table(seedName); }, _utf8);
+			}
+
 			const auto& attributeConfig = _configuration[CONFIG][GENERATE_FILTER];
-			attribure_t attributes{
+			_attributes = {
 				attributeConfig[OPTIONAL_FILTER][NUMBER].get<bool>(),
 				attributeConfig[OPTIONAL_FILTER][LOWER_LETTER].get<bool>(),
 				attributeConfig[OPTIONAL_FILTER][UPPER_LETTER].get<bool>(),
 				attributeConfig[OPTIONAL_FILTER][SPECIAL_LETTER].get<bool>(),
 				attributeConfig[ACHIEVE_OPTIONAL].get<std::size_t>(),
-				attributeConfig[MINIMUM_LENGTH].get<std::size_t>()
+				attributeConfig[MINIMUM_LENGTH].get<std::size_t>(),
+				{},
+				{}
 			};
-			passwords.erase(std::remove_if(passwords.begin(), passwords.end(), [&](const auto& password) {
-				return !password_has_achieved_attributes(password, attributes); }), passwords.end());
+			for (const auto& letter : get_seed_content(SPECIAL_LETTER)) {
+				for (auto it = letter.data(), end = letter.data() + letter.size(); it != end;) {
+					const auto ch = static_cast<unsigned char>(*it);
+					if (ch < 0x80 || !_utf8) {
+						_attributes.specialLetters[ch] = true;
+						it++;
+					} else {
+						_attributes.specialCodePoints.emplace_back(utf8::decode(it, end));
+					}
+				}
+			}
+			std::sort(_attributes.specialCodePoints.begin(), _attributes.specialCodePoints.end());
+
+			// Compile the plan so that inactive stages are skipped per candidate
+			_plan.variant = capitalize || _variants.size() > 1;
+			_plan.mutate = !_mutatorChain.empty();
+			_plan.filter = _attributes.achiveOptional > 0 || _attributes.minimumLength > 0;
 		} catch (const std::exception& ex) {
-			_mainLogger->critical("Failed to parse configuration file for password filtering with {}.", ex.what());
+			_mainLogger->critical("Failed to parse configuration file for generate rule loading with {}.", ex.what());
+			return false;
 		}
+		return true;
 	}
 
-	/// <summary> Password capitalize. </summary>
-	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
-	/// <param name="passwords"> [in,out] The passwords. </param>
-	void password_capitalize(string_array_t& passwords) const {
+	/// <summary>
+	///		<para> Plans formations so that provable duplicates are never generated. </para>
+	///		<para> Positions of a formation are its segments and the separator set, a formation is dropped if every </para>
+	///		<para> position is a subset of the same position of an earlier one. If only one position is not a subset, </para>
+	///		<para> entries shared with the earlier one are removed from it. Ambiguous segmentations are reported only. </para>
+	///	</summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="formations"> [in,out] The formations, should be invoked after load_seed_tables(). </param>
+	/// <returns> True if it succeeds, false if it fails. </returns>
+	bool plan_formations(std::vector<formation_t>& formations) const {
 		try {
-			if (_configuration[CONFIG][GENERATE_RULE][CAPITALIZE].get<bool>()) {
-				std::for_each(passwords.begin(), passwords.end(), [&](auto& password) {password[0] = std::toupper(password[0]); });
+			// Sorted copy of every table for subset test, keyed by the table to keep it alive
+			std::map<seed_table_t, string_array_t> sortedTables;
+			const auto sorted = [&](const seed_table_t& table) -> const string_array_t& {
+				auto it = sortedTables.find(table);
+				if (it == sortedTables.end()) {
+					string_array_t entries(*table);
+					std::sort(entries.begin(), entries.end());
+					it = sortedTables.emplace(table, std::move(entries)).first;
+				}
+				return it->second;
+			};
+			// Separator set only matters with more than one segment, no separator is the same as an empty one
+			const auto noSeparator = std::make_shared<const string_array_t>(string_array_t{ "" });
+			const auto positions = [&](const formation_t& formation) {
+				auto tables = formation.tables;
+				if (tables.size() > 1) {
+					tables.emplace_back(formation.separators != nullptr ? formation.separators : noSeparator);
+				}
+				return tables;
+			};
+
+			// Positions before removal are still fully generated, removed entries are covered by earlier formations
+			std::vector<formation_t> planned;
+			std::vector<std::vector<seed_table_t>> coverage;
+			for (auto& formation : formations) {
+				const auto original = positions(formation);
+				bool redundant = false;
+				for (std::size_t j = 0; j < planned.size() && !redundant; j++) {
+					const auto earlier = &planned[j];
+					const auto& earlierTables = coverage[j];
+					if (earlierTables.size() != original.size()) {
+						continue;
+					}
+					const auto tables = positions(formation);
+					std::vector<std::size_t> uncovered;
+					for (std::size_t i = 0; i < tables.size(); i++) {
+						const auto& lhs = sorted(tables[i]);
+						const auto& rhs = sorted(earlierTables[i]);
+						if (tables[i] != earlierTables[i] && !std::includes(rhs.cbegin(), rhs.cend(), lhs.cbegin(), lhs.cend())) {
+							uncovered.emplace_back(i);
+						}
+					}
+					if (uncovered.empty()) {
+						_mainLogger->info("Formation [{}] is covered by formation [{}] and dropped.", formation_name(formation), formation_name(*earlier));
+						redundant = true;
+					} else if (uncovered.size() == 1) {
+						// Candidates with a shared entry at this position are generated by the earlier formation
+						const auto position = uncovered.front();
+						const auto& rhs = sorted(earlierTables[position]);
+						string_array_t entries;
+						std::copy_if(tables[position]->cbegin(), tables[position]->cend(), std::back_inserter(entries), [&](const auto& entry) {
+							return !std::binary_search(rhs.cbegin(), rhs.cend(), entry); });
+						if (entries.size() == tables[position]->size()) {
+							continue;
+						}
+						_mainLogger->info("Removed {} entries shared with formation [{}] from {} of formation [{}].", tables[position]->size() - entries.size(),
+										  formation_name(*earlier), position < formation.segments.size() ? formation.segments[position] : "separator", formation_name(formation));
+						const auto reduced = std::make_shared<const string_array_t>(std::move(entries));
+						if (position < formation.tables.size()) {
+							formation.tables[position] = reduced;
+						} else {
+							formation.separators = reduced;
+						}
+						redundant = reduced->empty();
+					}
+				}
+				if (redundant) {
+					continue;
+				}
+
+				// Adjacent segments joined without separator may compose a candidate in two ways
+				const auto joined = formation.separators == nullptr || std::find(formation.separators->cbegin(), formation.separators->cend(), "") != formation.separators->cend();
+				for (std::size_t i = 0; joined && i + 1 < formation.tables.size(); i++) {
+					std::string example;
+					if (find_ambiguity(sorted(formation.tables[i]), sorted(formation.tables[i + 1]), example)) {
+						_mainLogger->warn("Formation [{}] is ambiguous between {} and {} like {}, use dedupe to drop duplicates.",
+										  formation_name(formation), formation.segments[i], formation.segments[i + 1], example);
+						break;
+					}
+				}
+				planned.emplace_back(std::move(formation));
+				coverage.emplace_back(original);
 			}
+			formations.swap(planned);
 		} catch (const std::exception& ex) {
-			_mainLogger->critical("Failed to parse configuration file for capitalize password with {}.", ex.what());
+			_mainLogger->critical("Failed to plan formations with {}.", ex.what());
+			return false;
 		}
+		return true;
 	}
 
-	/// <summary> Password generate. </summary>
+	/// <summary>
+	///		<para> Sorts seed tables of all formations so that enumeration order is lexicographic. </para>
+	///		<para> It requires every segment table and separator set to be prefix-free, and no variant or mutator to change bytes. </para>
+	///	</summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="formations"> [in,out] The formations, tables are replaced by sorted ones only if all of them qualify. </param>
+	/// <returns> True if enumeration of every formation is lexicographic. </returns>
+	bool sort_formations(std::vector<formation_t>& formations) const {
+		if (_plan.mutate || _variants.size() != 1 || _variants.front().capitalize || _variants.front().transform) {
+			_mainLogger->info("Capitalize, transform or mutator changes the candidates, sorting the output instead of the enumeration.");
+			return false;
+		}
+		std::map<seed_table_t, seed_table_t> sortedTables;
+		// Candidates are ordered by the first different entry only if no entry is a prefix of another in the same table
+		const auto sorted = [&](const seed_table_t& table) -> seed_table_t {
+			auto& cached = sortedTables[table];
+			if (cached == nullptr) {
+				string_array_t entries(*table);
+				std::sort(entries.begin(), entries.end());
+				const auto prefix = std::adjacent_find(entries.cbegin(), entries.cend(), [](const auto& lhs, const auto& rhs) {
+					return rhs.compare(0, lhs.size(), lhs) == 0; });
+				if (prefix != entries.cend()) {
+					_mainLogger->info("Entry '{}' is a prefix of '{}', sorting the output instead of the enumeration.", *prefix, *std::next(prefix));
+					return nullptr;
+				}
+				cached = std::make_shared<const string_array_t>(std::move(entries));
+			}
+			return cached;
+		};
+
+		auto planned = formations;
+		for (auto& formation : planned) {
+			for (auto& table : formation.tables) {
+				if ((table = sorted(table)) == nullptr) {
+					return false;
+				}
+			}
+			if (formation.separators != nullptr && formation.tables.size() > 1 && (formation.separators = sorted(formation.separators)) == nullptr) {
+				return false;
+			}
+		}
+		formations.swap(planned);
+		return true;
+	}
+
+	/// <summary> Finds two ways to compose the same string from entries of adjacent segments, like "ab" + "c" and "a" + "bc". </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="lhs">	   The sorted entries of left segment. </param>
+	/// <param name="rhs">	   The sorted entries of right segment. </param>
+	/// <param name="example"> [out] The ambiguous composition if found. </param>
+	/// <returns> True if found, false if there is none or the search gives up. </returns>
+	bool find_ambiguity(const string_array_t& lhs, const string_array_t& rhs, std::string& example) const {
+		constexpr std::size_t probeLimit = std::size_t(1) << 22;
+		const auto starts_with = [](const std::string& text, const std::string& prefix) { return text.compare(0, prefix.size(), prefix) == 0; };
+		std::size_t probes = 0;
+		// left + suffix + right == left + (suffix + right), both "left + suffix" and "suffix + right" are entries
+		for (auto left = lhs.cbegin(); left != lhs.cend(); left++) {
+			for (auto longer = std::next(left); longer != lhs.cend() && starts_with(*longer, *left); longer++) {
+				const auto suffix = longer->substr(left->size());
+				for (auto right = std::lower_bound(rhs.cbegin(), rhs.cend(), suffix); right != rhs.cend() && starts_with(*right, suffix); right++) {
+					if (++probes > probeLimit) {
+						return false;
+					}
+					if (!suffix.empty() && std::binary_search(rhs.cbegin(), rhs.cend(), right->substr(suffix.size()))) {
+						example = "\"" + *longer + "\" + \"" + right->substr(suffix.size()) + "\" and \"" + *left + "\" + \"" + *right + "\"";
+						return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+
+	/// <summary> Builds the keyspace of a formation, should be invoked after load_seed_tables() and load_generate_rule(). </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="formation"> The formation. </param>
+	/// <returns> The keyspace. </returns>
+	Keyspace build_keyspace(const formation_t& formation) {
+		// Fingerprints are composed from entry hashes for dedupe, mutated candidates are always hashed by bytes
+		const auto composed = (_option.dedupe || _option.dedupeApproximate || _option.estimate || !_option.historyPath.empty()) && !_plan.mutate;
+		const auto hashes = [&](const seed_table_t& table) -> std::shared_ptr<const Keyspace::hash_array_t> {
+			if (!composed) {
+				return nullptr;
+			}
+			auto& cached = _seedHashes[table];
+			if (cached == nullptr) {
+				cached = Keyspace::hash_table(*table);
+			}
+			return cached;
+		};
+
+		Keyspace keyspace;
+		for (std::size_t i = 0; i < formation.segments.size(); i++) {
+			keyspace.add_segment(formation.tables[i], hashes(formation.tables[i]));
+			// Separator radix runs right after the first segment
+			if (i == 0 && formation.separators != nullptr && formation.segments.size() > 1) {
+				keyspace.add_separator(formation.separators, hashes(formation.separators));
+			}
+		}
+		std::for_each(_mutatorChain.affixes().cbegin(), _mutatorChain.affixes().cend(), [&](const auto& affix) {
+			keyspace.add_affix(affix); });
+		keyspace.add_variant(_variants.size());
+		return keyspace;
+	}
+
+	/// <summary> Single password transformation by specified rules. </summary>
+	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
+	/// <param name="password"> [in,out] The password. </param>
+	/// <returns> True if any rule changed the password. </returns>
+	bool password_transform(std::string& password) const {
+		static thread_local std::string transformed;
+		transformed.clear();
+		bool changed = false;
+		for (std::size_t i = 0; i < password.size();) {
+			const auto rule = std::find_if(_transformRules.cbegin(), _transformRules.cend(), [&](const auto& rule) {
+				return password.compare(i, rule.first.size(), rule.first) == 0; });
+			if (rule == _transformRules.cend()) {
+				transformed += password[i++];
+			} else {
+				transformed += rule->second;
+				changed = changed || (rule->first != rule->second);
+				i += rule->first.size();
+			}
+		}
+		password.swap(transformed);
+		return changed;
+	}
+
+	/// <summary> Password capitalize. </summary>
+	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
+	/// <param name="password"> [in,out] The password. </param>
+	void password_capitalize(std::string& password) const {
+		if (password.empty()) {
+			return;
+		}
+		const auto first = static_cast<unsigned char>(password[0]);
+		if (first < 0x80 || !_utf8) {
+			password[0] = static_cast<std::string::value_type>(std::toupper(first));
+			return;
+		}
+		// Replace the first code point in UTF-8 mode
+		const char* next = password.data();
+		const auto codePoint = utf8::decode(next, password.data() + password.size());
+		const auto upper = utf8::to_upper(codePoint);
+		if (upper != codePoint) {
+			std::string capitalized;
+			utf8::encode(upper, capitalized);
+			password.replace(0, static_cast<std::size_t>(next - password.data()), capitalized);
+		}
+	}
+
+	/// <summary> Applies the variant to a composed password. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="password"> [in,out] The password. </param>
+	/// <param name="variant">  The variant. </param>
+	/// <returns> False if the variant duplicates another variant and should be dropped. </returns>
+	bool password_variant(std::string& password, const variant_t& variant) const {
+		if (variant.capitalize) {
+			password_capitalize(password);
+		}
+		// An untouched transform variant is the same as the original one
+		return !variant.transform || password_transform(password);
+	}
+
+	/// <summary> Weather password has specified attribute defined in configuration. </summary>
 	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
-	/// <param name="base">  [in,out] The base. </param>
-	/// <param name="addon"> The addon. </param>
-	string_array_t password_generate(string_array_t& base, const string_array_t& addon) const {
-		string_array_t generated;
-		generated.reserve(std::max(base.size(), std::size_t(1)) * addon.size());
-
-		std::for_each(addon.cbegin(), addon.cend(), [&](const auto& addonSingle) {
-			if (base.empty()) {
-				generated.emplace_back(addonSingle);
+	/// <param name="password"> The password. </param>
+	/// <param name="length">   The password length. </param>
+	/// <returns> True if it password has specified attribute, false otherwise. </returns>
+	bool password_has_achieved_attributes(const char* password, const std::size_t length, const attribure_t& attributes) const {
+		bool hasLowerLetter = false;
+		bool hasUpperLetter = false;
+		bool hasNumber = false;
+		bool hasSpecialLetter = false;
+		std::size_t characters = 0;
+		for (auto it = password, end = password + length; it != end; characters++) {
+			const auto ch = static_cast<unsigned char>(*it);
+			if (ch < 0x80 || !_utf8) {
+				// ASCII fast path, every byte is a character without UTF-8 mode
+				hasLowerLetter = hasLowerLetter || (std::islower(ch) != 0);
+				hasUpperLetter = hasUpperLetter || (std::isupper(ch) != 0);
+				hasNumber = hasNumber || (std::isdigit(ch) != 0);
+				hasSpecialLetter = hasSpecialLetter || attributes.specialLetters[ch];
+				it++;
 			} else {
-				std::transform(base.begin(), base.end(), std::back_inserter(generated), [&](const auto& baseSingle) {
-					return baseSingle + addonSingle; });
-			}});
+				const auto codePoint = utf8::decode(it, end);
+				hasLowerLetter = hasLowerLetter || utf8::is_lower(codePoint);
+				hasUpperLetter = hasUpperLetter || utf8::is_upper(codePoint);
+				hasSpecialLetter = hasSpecialLetter || std::binary_search(attributes.specialCodePoints.cbegin(), attributes.specialCodePoints.cend(), codePoint);
+			}
+		}
+
+		// Meet the request
+		const std::size_t achievedOptional = (attributes.optLowerLetter == hasLowerLetter) + (attributes.optUpperLetter == hasUpperLetter) +
+			(attributes.optNumber == hasNumber) + (attributes.optSpecialLetter == hasSpecialLetter);
+
+		return ((achievedOptional >= attributes.achiveOptional) && (characters >= attributes.minimumLength));
+	}
+
+	/// <summary> Password filter. </summary>
+	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
+	/// <param name="batch"> [in, out] The candidate batch. </param>
+	void password_filter(CandidateBatch& batch) const {
+		batch.remove_if([&](const char* password, const std::size_t length) {
+			return !password_has_achieved_attributes(password, length, _attributes); });
+	}
+
+	/// <summary> Password generate, composes, transforms and filters the candidates of ranks in [begin, end) in a single pass. </summary>
+	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
+	/// <param name="keyspace"> The keyspace. </param>
+	/// <param name="begin">    The first rank. </param>
+	/// <param name="end">	    The rank after the last one. </param>
+	/// <param name="batch">    [in,out] The candidate batch. </param>
+	/// <param name="sketch">   [in,out] The sketch of distinct candidates, null if not estimated. </param>
+	void password_generate(const Keyspace& keyspace, const rank_t begin, const rank_t end, CandidateBatch& batch, HyperLogLog* sketch = nullptr,
+						   std::vector<partition_batch_t>* partitions = nullptr) {
+		Keyspace::digits_t digits;
+		std::string password;
+		keyspace.decode(begin, digits);
+		const auto affixPosition = keyspace.first_of(radix_kind_t::AFFIX);
+		const auto variantPosition = keyspace.first_of(radix_kind_t::VARIANT);
+		const auto composable = keyspace.composable();
+		rank_t estimated = 0;
+		for (rank_t rank = begin; rank < end; rank++, keyspace.next(digits)) {
+			keyspace.compose(digits, password);
+			// Each candidate runs through all stages while it is still in cache
+			const auto& variant = _variants[digits[variantPosition]];
+			if (_plan.variant && !password_variant(password, variant)) {
+				continue;
+			}
+			if (_plan.mutate && !_mutatorChain.apply(password, digits.data() + affixPosition)) {
+				continue;
+			}
+			if (_plan.filter && !password_has_achieved_attributes(password.data(), password.size(), _attributes)) {
+				continue;
+			}
+			if (_plan.dedupe || sketch != nullptr || partitions != nullptr) {
+				// Bytes of the composed candidate are unchanged without capitalize and transform
+				const auto value = (composable && !variant.capitalize && !variant.transform) ?
+					keyspace.fingerprint(digits) : fingerprint(password.data(), password.size());
+				if (sketch != nullptr) {
+					sketch->add(value);
+					estimated++;
+				}
+				if (partitions != nullptr) {
+					// Deduplicated by the partition when it is serialized
+					auto& partition = (*partitions)[partition_of(value)];
+					partition.candidates.push(password);
+					partition.fingerprints.push_back(value);
+					continue;
+				}
+				if (_plan.dedupe && !password_unique(value)) {
+					continue;
+				}
+			}
+			batch.push(password);
+		}
+		_estimated += estimated;
+	}
+
+	/// <summary> Password generate in stages, all candidates of ranks in [begin, end) are composed before the filter pass. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="keyspace"> The keyspace. </param>
+	/// <param name="begin">    The first rank. </param>
+	/// <param name="end">	    The rank after the last one. </param>
+	/// <param name="batch">    [in,out] The candidate batch. </param>
+	void password_generate_staged(const Keyspace& keyspace, const rank_t begin, const rank_t end, CandidateBatch& batch) {
+		Keyspace::digits_t digits;
+		std::string password;
+		keyspace.decode(begin, digits);
+		const auto affixPosition = keyspace.first_of(radix_kind_t::AFFIX);
+		for (rank_t rank = begin; rank < end; rank++, keyspace.next(digits)) {
+			keyspace.compose(digits, password);
+			if (password_variant(password, _variants[keyspace.digit_of(digits, radix_kind_t::VARIANT)]) &&
+				_mutatorChain.apply(password, digits.data() + affixPosition)) {
+				batch.push(password);
+			}
+		}
+		password_filter(batch);
+		password_deduplicate(batch);
+	}
+
+	/// <summary> Query if the password is emitted for the first time, always true without dedupe, may be a false positive with approximate dedupe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="password"> The password. </param>
+	/// <param name="length">   The password length. </param>
+	/// <returns> False if it is a duplicate. </returns>
+	bool password_unique(const char* password, const std::size_t length) { return password_unique(fingerprint(password, length)); }
+
+	/// <summary> Query if the fingerprint is emitted for the first time, always true without dedupe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="value"> The fingerprint of password. </param>
+	/// <returns> False if it is a duplicate. </returns>
+	bool password_unique(const fingerprint_t value) {
+		if ((_dedupe == nullptr || _dedupe->insert(value)) && (_approximate == nullptr || _approximate->insert(value))) {
+			return true;
+		}
+		_duplicates++;
+		return false;
+	}
 
-		return generated;
+	/// <summary> Removes the duplicates from batch. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="batch"> [in,out] The candidate batch. </param>
+	void password_deduplicate(CandidateBatch& batch) {
+		if (_plan.dedupe) {
+			batch.remove_if([&](const char* password, const std::size_t length) { return !password_unique(password, length); });
+		}
 	}
 
 	/// <summary> Appends the additional dictionary. </summary>
 	/// <remarks> BlueWingTan, 2020/4/18. </remarks>
-	void append_additional_dictionary() {
+	/// <param name="passwords"> The passwords of additional dictionaries. </param>
+	void append_additional_dictionary(const string_array_t& passwords) {
+		CandidateBatch content;
+		std::for_each(passwords.cbegin(), passwords.cend(), [&](const auto& password) { content.push(password); });
+		if (_estimator != nullptr) {
+			std::lock_guard<std::mutex> lock(_estimatorLock);
+			std::for_each(passwords.cbegin(), passwords.cend(), [&](const auto& password) {
+				_estimator->add(fingerprint(password.data(), password.size())); });
+			_estimated += passwords.size();
+		}
+		if (_plan.partition) {
+			std::vector<partition_batch_t> partitionBatches(_partitions.size());
+			std::for_each(passwords.cbegin(), passwords.cend(), [&](const auto& password) {
+				const auto value = fingerprint(password.data(), password.size());
+				auto& partition = partitionBatches[partition_of(value)];
+				partition.candidates.push(password);
+				partition.fingerprints.push_back(value); });
+			password_serial(partitionBatches);
+			return;
+		}
+		if (_positional != nullptr) {
+			password_serial_at(content, 0);
+			return;
+		}
+		password_deduplicate(content);
+		password_serial(content);
+	}
+
+	/// <summary> Loads passwords of all additional dictionaries. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> The passwords. </returns>
+	string_array_t load_additional_dictionary() const {
+		string_array_t passwords;
 		try {
 			for (const auto& additionalDict : _configuration[CONFIG][GENERATE_ADDITIONAL].get<string_array_t>()) {
 				std::fstream file(DIST_PATH + additionalDict);
 				if (file) {
-					string_array_t content;
-					std::copy(std::istream_iterator<std::string>(file), std::istream_iterator<std::string>(), std::back_inserter(content));
-					password_serial(content);
+					string_array_t contents(std::istream_iterator<std::string>(file), (std::istream_iterator<std::string>()));
+					if (_utf8) {
+						normalize_seed(contents, additionalDict);
+					}
+					std::move(contents.begin(), contents.end(), std::back_inserter(passwords));
 				}
 			}
 		} catch (const std::exception& ex) {
 			_mainLogger->critical("Failed to parse configuration file for append additional dictionary with {}.", ex.what());
 		}
+		return passwords;
 	}
 };	// class PasswordMaker
 }	// namespace bwt
\ No newline at end of file
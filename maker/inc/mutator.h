@@ -0,0 +1,185 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+#include <utf8.h>
+
+namespace bwt {
+/// <summary> Kind of a structural mutator. </summary>
+enum class mutator_kind_t {
+	REVERSE,	// pass -> ssap
+	DUPLICATE,	// pass -> passpass
+	REFLECT,	// pass -> passssap
+	PREPEND,	// pass -> @pass, one candidate per entry of the seed table
+	APPEND,		// pass -> pass2020, one candidate per entry of the seed table
+	TRUNCATE	// pass -> pa, with argument 2
+};
+
+/// <summary> One step of the mutator chain. </summary>
+struct mutator_t {
+	mutator_kind_t kind;
+	std::shared_ptr<const std::vector<std::string>> table;
+	std::size_t argument;
+};
+
+/// <summary>
+///		<para> Chain of structural mutators applied to every candidate in a single pass. </para>
+///		<para> Every prepend/append mutator owns one affix radix in the keyspace, in chain order. </para>
+///	</summary>
+class MutatorChain {
+public:
+	using string_array_t = std::vector<std::string>;
+	using table_resolver_t = std::function<std::shared_ptr<const string_array_t>(const std::string&)>;
+
+	/// <summary> Default constructor, an empty chain keeps every candidate as is. </summary>
+	MutatorChain() = default;
+
+	/// <summary> Parses the chain like [ "reverse", "append:year", "truncate:12" ]. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::invalid_argument"> Thrown when a mutator or its argument is illegal. </exception>
+	/// <param name="chain">		 The chain definition. </param>
+	/// <param name="maximumLength"> The maximum length of mutated candidates. </param>
+	/// <param name="resolver">		 Resolves a seed name to its table. </param>
+	/// <param name="utf8">			 True to reverse and truncate by UTF-8 code points instead of bytes. </param>
+	MutatorChain(const string_array_t& chain, const std::size_t maximumLength, const table_resolver_t& resolver, const bool utf8 = false) :
+		_maximumLength(maximumLength),
+		_utf8(utf8) {
+		for (const auto& definition : chain) {
+			const auto delimiter = definition.find(':');
+			const auto name = definition.substr(0, delimiter);
+			const auto argument = (delimiter == std::string::npos) ? std::string() : definition.substr(delimiter + 1);
+
+			if (name == "reverse") {
+				_mutators.push_back({ mutator_kind_t::REVERSE, nullptr, 0 });
+			} else if (name == "duplicate") {
+				_mutators.push_back({ mutator_kind_t::DUPLICATE, nullptr, 0 });
+			} else if (name == "reflect") {
+				_mutators.push_back({ mutator_kind_t::REFLECT, nullptr, 0 });
+			} else if (name == "prepend" || name == "append") {
+				if (argument.empty()) {
+					throw std::invalid_argument("mutator '" + definition + "' requires a seed name");
+				}
+				_mutators.push_back({ name == "prepend" ? mutator_kind_t::PREPEND : mutator_kind_t::APPEND, resolver(argument), 0 });
+				_affixes.push_back(_mutators.back().table);
+			} else if (name == "truncate") {
+				if (argument.empty() || argument.find_first_not_of("0123456789") != std::string::npos) {
+					throw std::invalid_argument("mutator '" + definition + "' requires a length");
+				}
+				_mutators.push_back({ mutator_kind_t::TRUNCATE, nullptr, std::stoul(argument) });
+			} else {
+				throw std::invalid_argument("unknown mutator '" + definition + "'");
+			}
+		}
+	}
+
+	/// <summary> Query if this chain does nothing. </summary>
+	bool empty() const { return _mutators.empty(); }
+
+	/// <summary> Gets the seed tables of affix mutators in chain order, each one is a radix of the keyspace. </summary>
+	const std::vector<std::shared_ptr<const string_array_t>>& affixes() const { return _affixes; }
+
+	/// <summary> Applies the whole chain to the candidate. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="candidate">   [in,out] The candidate. </param>
+	/// <param name="affixDigits"> Digits of the affix radixes in chain order, may be null without affix mutators. </param>
+	/// <returns> False if the candidate or the mutated one would exceed the maximum length and should be dropped. </returns>
+	bool apply(std::string& candidate, const std::size_t* affixDigits) const {
+		static thread_local std::string mutated;
+		if (candidate.size() > _maximumLength) {
+			return false;
+		}
+		for (const auto& mutator : _mutators) {
+			const auto length = candidate.size();
+			switch (mutator.kind) {
+			case mutator_kind_t::REVERSE:
+				reverse(candidate, 0);
+				break;
+			case mutator_kind_t::DUPLICATE:
+				if (length * 2 > _maximumLength) {
+					return false;
+				}
+				candidate.append(candidate.data(), length);
+				break;
+			case mutator_kind_t::REFLECT:
+				if (length * 2 > _maximumLength) {
+					return false;
+				}
+				candidate.append(candidate.data(), length);
+				reverse(candidate, length);
+				break;
+			case mutator_kind_t::PREPEND:
+			case mutator_kind_t::APPEND: {
+				const auto& affix = (*mutator.table)[*affixDigits++];
+				if (length + affix.size() > _maximumLength) {
+					return false;
+				}
+				if (mutator.kind == mutator_kind_t::APPEND) {
+					candidate += affix;
+				} else {
+					mutated.assign(affix).append(candidate);
+					candidate.swap(mutated);
+				}
+				break;
+			}
+			case mutator_kind_t::TRUNCATE:
+				candidate.resize(_utf8 ? utf8::offset_of(candidate.data(), length, mutator.argument) : std::min(length, mutator.argument));
+				break;
+			}
+		}
+		return candidate.size() <= _maximumLength;
+	}
+
+private:
+	/// <summary> Reverses the candidate from given offset, by code points in UTF-8 mode. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="candidate"> [in,out] The candidate. </param>
+	/// <param name="offset">    The offset. </param>
+	void reverse(std::string& candidate, const std::size_t offset) const {
+		const auto begin = &candidate[0] + offset;
+		const auto end = &candidate[0] + candidate.size();
+		if (_utf8 && !utf8::is_ascii(begin, static_cast<std::size_t>(end - begin))) {
+			utf8::reverse(begin, end);
+		} else {
+			std::reverse(begin, end);
+		}
+	}
+
+	std::vector<mutator_t> _mutators;
+	std::vector<std::shared_ptr<const string_array_t>> _affixes;
+	std::size_t _maximumLength{ 0 };
+	bool _utf8{ false };
+};
+}	// namespace bwt
@@ -0,0 +1,177 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
+#include <future>
+#include <vector>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+
+namespace bwt {
+/// <summary> Order of sorted output. </summary>
+enum class sort_order_t {
+	LEXICOGRAPHIC,	// Byte-wise, the same order as std::string
+	LENGTH			// Shorter first, lexicographic among the same length
+};
+
+/// <summary> A line without its line feed. </summary>
+using line_t = std::pair<const char*, std::size_t>;
+
+/// <summary> Compares two lines in given order. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="lhs">   The left line. </param>
+/// <param name="rhs">   The right line. </param>
+/// <param name="order"> The order. </param>
+/// <returns> True if the left line goes first. </returns>
+inline bool line_less(const line_t& lhs, const line_t& rhs, const sort_order_t order) {
+	if (order == sort_order_t::LENGTH && lhs.second != rhs.second) {
+		return lhs.second < rhs.second;
+	}
+	const auto result = std::memcmp(lhs.first, rhs.first, std::min(lhs.second, rhs.second));
+	return result < 0 || (result == 0 && lhs.second < rhs.second);
+}
+
+/// <summary> Query if two lines have the same bytes. </summary>
+inline bool line_equal(const line_t& lhs, const line_t& rhs) {
+	return lhs.second == rhs.second && std::memcmp(lhs.first, rhs.first, lhs.second) == 0;
+}
+
+namespace detail {
+/// <summary> Ranges shorter than this are sorted by insertion sort. </summary>
+constexpr std::size_t RADIX_INSERTION_THRESHOLD = 32;
+
+/// <summary> Bucket of the line at given depth, 0 for lines shorter than depth + 1. </summary>
+inline std::size_t radix_bucket(const line_t& line, const std::size_t depth) {
+	return depth < line.second ? static_cast<std::size_t>(static_cast<unsigned char>(line.first[depth])) + 1 : 0;
+}
+
+/// <summary> Lexicographic MSD radix sort of lines sharing the first depth bytes. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="lines">  [in,out] The lines. </param>
+/// <param name="buffer"> [in,out] Scratch buffer of the same size. </param>
+/// <param name="count">  Number of lines. </param>
+/// <param name="depth">  Number of leading bytes already sorted. </param>
+inline void radix_sort(line_t* lines, line_t* buffer, const std::size_t count, const std::size_t depth) {
+	if (count < RADIX_INSERTION_THRESHOLD) {
+		for (std::size_t i = 1; i < count; i++) {
+			const auto line = lines[i];
+			auto j = i;
+			for (; j > 0 && line_less({ line.first + depth, line.second - depth }, { lines[j - 1].first + depth, lines[j - 1].second - depth }, sort_order_t::LEXICOGRAPHIC); j--) {
+				lines[j] = lines[j - 1];
+			}
+			lines[j] = line;
+		}
+		return;
+	}
+
+	std::size_t offsets[258] = {};
+	for (std::size_t i = 0; i < count; i++) {
+		offsets[radix_bucket(lines[i], depth) + 2]++;
+	}
+	for (std::size_t i = 2; i < 258; i++) {
+		offsets[i] += offsets[i - 1];
+	}
+	for (std::size_t i = 0; i < count; i++) {
+		buffer[offsets[radix_bucket(lines[i], depth) + 1]++] = lines[i];
+	}
+	std::copy(buffer, buffer + count, lines);
+
+	// Lines in bucket 0 are equal, the others share one more byte
+	for (std::size_t bucket = 1; bucket < 257; bucket++) {
+		const auto begin = offsets[bucket];
+		const auto size = offsets[bucket + 1] - begin;
+		if (size > 1) {
+			radix_sort(lines + begin, buffer + begin, size, depth + 1);
+		}
+	}
+}
+}	// namespace detail
+
+/// <summary>
+///		<para> Parallel MSD radix sort of lines. </para>
+///		<para> The first pass splits lines by length or by first byte, then buckets are sorted by the threads. </para>
+///	</summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="lines">		[in,out] The lines. </param>
+/// <param name="order">		The order. </param>
+/// <param name="threadNumber"> Number of threads. </param>
+inline void radix_sort(std::vector<line_t>& lines, const sort_order_t order, const std::size_t threadNumber = 1) {
+	if (lines.size() < 2) {
+		return;
+	}
+	std::vector<line_t> buffer(lines.size());
+
+	// Counting sort by the key of first pass, every bucket is then sorted lexicographically
+	std::vector<std::size_t> offsets;
+	std::size_t depth = 0;
+	const auto key = [&](const line_t& line) { return order == sort_order_t::LENGTH ? line.second : detail::radix_bucket(line, 0); };
+	if (order == sort_order_t::LENGTH) {
+		offsets.assign(std::max_element(lines.cbegin(), lines.cend(), [](const line_t& lhs, const line_t& rhs) {
+			return lhs.second < rhs.second; })->second + 2, 0);
+	} else {
+		offsets.assign(258, 0);
+		depth = 1;
+	}
+	for (const auto& line : lines) {
+		offsets[key(line) + 1]++;
+	}
+	std::partial_sum(offsets.cbegin(), offsets.cend(), offsets.begin());
+	for (const auto& line : lines) {
+		buffer[offsets[key(line)]++] = line;
+	}
+	lines.swap(buffer);
+	// Offsets now hold the end of every bucket
+	std::vector<std::pair<std::size_t, std::size_t>> buckets;
+	for (std::size_t bucket = 0, begin = 0; bucket + 1 < offsets.size(); begin = offsets[bucket++]) {
+		if (offsets[bucket] - begin > 1 && (order == sort_order_t::LENGTH || bucket != 0)) {
+			buckets.emplace_back(begin, offsets[bucket] - begin);
+		}
+	}
+
+	// Larger buckets first, threads take the next bucket until all are sorted
+	std::sort(buckets.begin(), buckets.end(), [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+	std::atomic<std::size_t> next{ 0 };
+	const auto worker = [&]() {
+		for (auto index = next++; index < buckets.size(); index = next++) {
+			detail::radix_sort(lines.data() + buckets[index].first, buffer.data() + buckets[index].first, buckets[index].second, depth);
+		}
+	};
+	std::vector<std::future<void>> workers;
+	for (std::size_t i = 1; i < std::min(threadNumber, buckets.size()); i++) {
+		workers.emplace_back(std::async(std::launch::async, worker));
+	}
+	worker();
+	std::for_each(workers.begin(), workers.end(), [](auto& result) { result.get(); });
+}
+}	// namespace bwt
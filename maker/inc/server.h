@@ -0,0 +1,493 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <list>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <functional>
+#include <stdexcept>
+#include <condition_variable>
+
+#ifndef _WIN32
+#include <csignal>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include <indexed.h>
+
+namespace bwt {
+/// <summary> Size of the frame header, the payload length and the chunk sequence number. </summary>
+constexpr std::size_t FRAME_HEADER_SIZE = 4 + 8;
+
+/// <summary> Milliseconds an idle connection waits before it checks whether serving is finished. </summary>
+constexpr int SERVE_POLL_INTERVAL = 100;
+
+/// <summary> A client of the chunk server, reported when it connects and when it leaves. </summary>
+struct served_client_t {
+	std::uint64_t id;
+	std::string peer;
+	std::uint64_t chunks;
+	std::uint64_t bytes;
+	/// <summary> True while it is connected. </summary>
+	bool connected;
+	/// <summary> True if it received the end of the stream. </summary>
+	bool finished;
+};
+
+#ifndef _WIN32
+/// <summary>
+///		<para> Serves chunks of the output to consumers connected to a Unix or TCP socket, every chunk goes to exactly one of them. </para>
+///		<para> A client asks for chunks by sending credits, a 32-bit little-endian count, and receives at most that many frames, </para>
+///		<para> each one a 32-bit little-endian payload length, a 64-bit little-endian sequence number and the candidates. </para>
+///		<para> A frame of length 0 ends the stream. Chunks are queued up to the depth, so the generator waits for the clients. </para>
+///	</summary>
+class ChunkServer {
+public:
+	/// <summary> Constructor, the socket is bound and clients are accepted from now on. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the address is invalid or can not be bound. </exception>
+	/// <param name="address"> The address, unix:/path or tcp:host:port, port 0 picks a free one. </param>
+	/// <param name="depth">   Number of chunks queued before the generator waits. </param>
+	/// <param name="report">  Called on the client thread when a client connects and when it leaves. </param>
+	ChunkServer(const std::string& address, const std::size_t depth, const std::function<void(const served_client_t&)>& report) :
+		_depth(std::max<std::size_t>(depth, 1)),
+		_report(report) {
+		// A client closing its socket fails sends with EPIPE instead of killing the process
+		std::signal(SIGPIPE, SIG_IGN);
+		if (address.compare(0, 5, "unix:") == 0) {
+			listen_unix(address.substr(5));
+		} else if (address.compare(0, 4, "tcp:") == 0 && address.rfind(':') > 4) {
+			const auto colon = address.rfind(':');
+			listen_tcp(address.substr(4, colon - 4), address.substr(colon + 1));
+		} else {
+			throw std::runtime_error("address " + address + " is neither unix:/path nor tcp:host:port");
+		}
+		_acceptor = std::thread(&ChunkServer::accept_clients, this);
+	}
+
+	/// <summary> Destructor, clients are disconnected if it is not closed. </summary>
+	~ChunkServer() {
+		stop();
+	}
+
+	ChunkServer(const ChunkServer&) = delete;
+	ChunkServer& operator=(const ChunkServer&) = delete;
+
+	/// <summary> Queues the chunk for the next client that asks, waits while the queue is full. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="chunk"> [in,out] The chunk, replaced by an empty one. </param>
+	/// <returns> True if it succeeds, false if the server is stopped with errno set. </returns>
+	bool push(std::string& chunk) {
+		std::unique_lock<std::mutex> lock(_lock);
+		if (_queue.size() >= _depth) {
+			const auto start = std::chrono::steady_clock::now();
+			_notFull.wait(lock, [&]() { return _queue.size() < _depth || _stopping; });
+			_waited += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		if (_stopping) {
+			errno = ECANCELED;
+			return false;
+		}
+		_queue.emplace_back();
+		_queue.back().first = _sequence++;
+		_queue.back().second.swap(chunk);
+		_notEmpty.notify_one();
+		return true;
+	}
+
+	/// <summary> Waits until every chunk is sent, ends the stream of every client and stops accepting. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	void close() {
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			_closing = true;
+			_notEmpty.notify_all();
+			_drained.wait(lock, [&]() { return finished() || _stopping; });
+		}
+		stop();
+	}
+
+	/// <summary> Gets the bound address, with the port picked by the system. </summary>
+	const std::string& address() const { return _address; }
+
+	/// <summary> Number of chunks sent. </summary>
+	std::uint64_t chunks() const { return _chunks; }
+
+	/// <summary> Number of payload bytes sent. </summary>
+	std::uint64_t bytes() const { return _bytes; }
+
+	/// <summary> Number of clients connected so far. </summary>
+	std::uint64_t clients() const { return _clients; }
+
+	/// <summary> Number of chunks queued but not sent yet. </summary>
+	std::size_t queued() {
+		std::lock_guard<std::mutex> lock(_lock);
+		return _queue.size() + _inFlight;
+	}
+
+	/// <summary> Seconds the generator waited for clients. </summary>
+	double waited() const { return _waited; }
+
+private:
+	/// <summary> A connected client. </summary>
+	struct client_t {
+		int socket;
+		std::uint64_t id;
+		std::string peer;
+		std::thread thread;
+		std::atomic<bool> done{ false };	// Set last by its thread, so that the acceptor may release it
+	};
+
+	/// <summary> Binds and listens on the Unix socket, an existing socket file is replaced. </summary>
+	void listen_unix(const std::string& path) {
+		sockaddr_un address{};
+		if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+			throw std::runtime_error("socket path " + path + " is empty or too long");
+		}
+		address.sun_family = AF_UNIX;
+		std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+		::unlink(path.c_str());
+		_listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (_listener < 0 || ::bind(_listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(_listener, SOMAXCONN) != 0) {
+			const auto error = "failed to listen on " + path + ": " + std::strerror(errno);
+			close_listener();
+			throw std::runtime_error(error);
+		}
+		_unixPath = path;
+		_address = "unix:" + path;
+	}
+
+	/// <summary> Binds and listens on the first usable address of the host and port. </summary>
+	void listen_tcp(const std::string& host, const std::string& port) {
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_PASSIVE;
+		addrinfo* addresses = nullptr;
+		const auto resolved = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses);
+		if (resolved != 0) {
+			throw std::runtime_error("failed to resolve " + host + ":" + port + ": " + ::gai_strerror(resolved));
+		}
+		std::string error = "no address of " + host;
+		for (auto entry = addresses; entry != nullptr && _listener < 0; entry = entry->ai_next) {
+			_listener = ::socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+			const int reuse = 1;
+			if (_listener < 0 || ::setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+				::bind(_listener, entry->ai_addr, entry->ai_addrlen) != 0 || ::listen(_listener, SOMAXCONN) != 0) {
+				error = "failed to listen on " + host + ":" + port + ": " + std::strerror(errno);
+				close_listener();
+			}
+		}
+		::freeaddrinfo(addresses);
+		if (_listener < 0) {
+			throw std::runtime_error(error);
+		}
+		sockaddr_storage bound{};
+		socklen_t size = sizeof(bound);
+		::getsockname(_listener, reinterpret_cast<sockaddr*>(&bound), &size);
+		_address = "tcp:" + peer_name(bound);
+	}
+
+	/// <summary> Gets the printable host and port of the socket address. </summary>
+	static std::string peer_name(const sockaddr_storage& address) {
+		char host[INET6_ADDRSTRLEN] = "";
+		if (address.ss_family == AF_INET) {
+			const auto& ipv4 = reinterpret_cast<const sockaddr_in&>(address);
+			::inet_ntop(AF_INET, &ipv4.sin_addr, host, sizeof(host));
+			return std::string(host) + ":" + std::to_string(ntohs(ipv4.sin_port));
+		}
+		if (address.ss_family == AF_INET6) {
+			const auto& ipv6 = reinterpret_cast<const sockaddr_in6&>(address);
+			::inet_ntop(AF_INET6, &ipv6.sin6_addr, host, sizeof(host));
+			return "[" + std::string(host) + "]:" + std::to_string(ntohs(ipv6.sin6_port));
+		}
+		return "local";
+	}
+
+	/// <summary> Acceptor thread, starts a thread for every client and releases clients that left until stopped. </summary>
+	void accept_clients() {
+		while (!_stopping) {
+			release_clients();
+			pollfd listener{ _listener, POLLIN, 0 };
+			if (::poll(&listener, 1, SERVE_POLL_INTERVAL) <= 0) {
+				continue;
+			}
+			sockaddr_storage peer{};
+			socklen_t size = sizeof(peer);
+			const auto socket = ::accept(_listener, reinterpret_cast<sockaddr*>(&peer), &size);
+			if (socket < 0) {
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(_lock);
+			_clients++;
+			_connections.emplace_back();
+			auto& client = _connections.back();
+			client.socket = socket;
+			client.id = _clients;
+			client.peer = peer_name(peer);
+			client.thread = std::thread(&ChunkServer::serve, this, std::ref(client));
+		}
+	}
+
+	/// <summary> Client thread, sends a chunk for every credit until the stream ends or the client leaves. </summary>
+	void serve(client_t& client) {
+		served_client_t served{ client.id, client.peer, 0, 0, true, false };
+		if (_report) {
+			_report(served);
+		}
+		std::uint64_t credits = 0;
+		auto connected = true;
+		while (connected) {
+			if (credits == 0) {
+				// Idle clients wake up regularly to end their stream once every chunk is sent
+				pollfd socket{ client.socket, POLLIN, 0 };
+				const auto ready = ::poll(&socket, 1, SERVE_POLL_INTERVAL);
+				if (ready > 0) {
+					char credit[4];
+					connected = receive_all(client.socket, credit, sizeof(credit));
+					credits += connected ? detail::get_fixed(credit, sizeof(credit)) : 0;
+					continue;
+				}
+				std::lock_guard<std::mutex> lock(_lock);
+				if (finished() || _stopping) {
+					break;
+				}
+				continue;
+			}
+			std::pair<std::uint64_t, std::string> chunk;
+			{
+				std::unique_lock<std::mutex> lock(_lock);
+				_notEmpty.wait(lock, [&]() { return !_queue.empty() || finished() || _stopping; });
+				if (_queue.empty()) {
+					break;
+				}
+				chunk = std::move(_queue.front());
+				_queue.pop_front();
+				_inFlight++;
+				_notFull.notify_one();
+			}
+			connected = send_frame(client.socket, chunk.first, chunk.second);
+			{
+				std::lock_guard<std::mutex> lock(_lock);
+				_inFlight--;
+				if (connected) {
+					_chunks++;
+					_bytes += chunk.second.size();
+				} else {
+					// The chunk goes to another client, so that none is lost
+					_queue.push_front(std::move(chunk));
+				}
+			}
+			_notEmpty.notify_all();
+			_drained.notify_all();
+			credits -= connected ? 1 : 0;
+			served.chunks += connected ? 1 : 0;
+			served.bytes += connected ? chunk.second.size() : 0;
+		}
+		auto complete = false;
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			complete = finished();
+		}
+		served.connected = false;
+		served.finished = connected && complete && send_frame(client.socket, 0, std::string());
+		::shutdown(client.socket, SHUT_RDWR);
+		if (_report) {
+			_report(served);
+		}
+		client.done = true;
+	}
+
+	/// <summary> Joins the threads of clients that left and closes their sockets, so that reconnecting clients do not accumulate. </summary>
+	void release_clients() {
+		std::lock_guard<std::mutex> lock(_lock);
+		for (auto client = _connections.begin(); client != _connections.end();) {
+			if (!client->done) {
+				++client;
+				continue;
+			}
+			client->thread.join();
+			::close(client->socket);
+			client = _connections.erase(client);
+		}
+	}
+
+	/// <summary> Query if generating is done and every chunk is sent, the lock must be held. </summary>
+	bool finished() const {
+		return _closing && _queue.empty() && _inFlight == 0;
+	}
+
+	/// <summary> Sends the frame of the chunk. </summary>
+	/// <returns> True if it succeeds. </returns>
+	static bool send_frame(const int socket, const std::uint64_t sequence, const std::string& payload) {
+		std::string header;
+		detail::put_fixed(header, payload.size(), 4);
+		detail::put_fixed(header, sequence, 8);
+		return send_all(socket, header.data(), header.size()) && send_all(socket, payload.data(), payload.size());
+	}
+
+	/// <summary> Sends all bytes, short sends and interrupts are retried. </summary>
+	/// <returns> True if it succeeds. </returns>
+	static bool send_all(const int socket, const char* data, std::size_t size) {
+#ifdef MSG_NOSIGNAL
+		const int flags = MSG_NOSIGNAL;
+#else
+		const int flags = 0;
+#endif
+		while (size > 0) {
+			const auto sent = ::send(socket, data, size, flags);
+			if (sent < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;
+			}
+			data += sent;
+			size -= static_cast<std::size_t>(sent);
+		}
+		return true;
+	}
+
+	/// <summary> Receives exactly the bytes, interrupts are retried. </summary>
+	/// <returns> True if it succeeds, false if the peer closed or it fails. </returns>
+	static bool receive_all(const int socket, char* data, std::size_t size) {
+		while (size > 0) {
+			const auto received = ::recv(socket, data, size, 0);
+			if (received < 0 && errno == EINTR) {
+				continue;
+			}
+			if (received <= 0) {
+				return false;
+			}
+			data += received;
+			size -= static_cast<std::size_t>(received);
+		}
+		return true;
+	}
+
+	/// <summary> Stops accepting, disconnects clients and waits for their threads. </summary>
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_stopping = true;
+		}
+		_notEmpty.notify_all();
+		_notFull.notify_all();
+		_drained.notify_all();
+		if (_acceptor.joinable()) {
+			_acceptor.join();
+		}
+		{
+			// Clients are cut off unless every chunk is sent, a client that stopped reading would block its thread forever
+			std::lock_guard<std::mutex> lock(_lock);
+			if (!finished()) {
+				for (auto& client : _connections) {
+					::shutdown(client.socket, SHUT_RDWR);
+				}
+			}
+		}
+		for (auto& client : _connections) {
+			if (client.thread.joinable()) {
+				client.thread.join();
+			}
+			::close(client.socket);
+		}
+		_connections.clear();
+		close_listener();
+		if (!_unixPath.empty()) {
+			::unlink(_unixPath.c_str());
+			_unixPath.clear();
+		}
+	}
+
+	/// <summary> Closes the listening socket. </summary>
+	void close_listener() {
+		if (_listener >= 0) {
+			::close(_listener);
+			_listener = -1;
+		}
+	}
+
+	std::size_t _depth;
+	std::function<void(const served_client_t&)> _report;
+	std::string _address;
+	std::string _unixPath;
+	int _listener{ -1 };
+	std::thread _acceptor;
+	std::list<client_t> _connections;
+	std::mutex _lock;
+	std::condition_variable _notEmpty;
+	std::condition_variable _notFull;
+	std::condition_variable _drained;
+	std::deque<std::pair<std::uint64_t, std::string>> _queue;
+	std::uint64_t _sequence{ 0 };
+	std::size_t _inFlight{ 0 };
+	bool _closing{ false };
+	std::atomic<bool> _stopping{ false };
+	std::atomic<std::uint64_t> _clients{ 0 };
+	std::uint64_t _chunks{ 0 };
+	std::uint64_t _bytes{ 0 };
+	double _waited{ 0 };
+};
+#else
+/// <summary> Placeholder where sockets are not supported, construction always fails. </summary>
+class ChunkServer {
+public:
+	ChunkServer(const std::string&, const std::size_t, const std::function<void(const served_client_t&)>&) {
+		throw std::runtime_error("serving is not supported on this platform");
+	}
+	bool push(std::string&) { return false; }
+	void close() {}
+	const std::string& address() const { return _address; }
+	std::uint64_t chunks() const { return 0; }
+	std::uint64_t bytes() const { return 0; }
+	std::uint64_t clients() const { return 0; }
+	std::size_t queued() { return 0; }
+	double waited() const { return 0; }
+
+private:
+	std::string _address;
+};
+#endif
+}	// namespace bwt
@@ -0,0 +1,406 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define PASSWORD_MAKER_URING
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+namespace bwt {
+/// <summary> Backend of the output writer. </summary>
+enum class io_backend_t {
+	BUFFERED,
+	URING
+};
+
+/// <summary> Alignment of offsets, sizes and buffers of direct I/O. </summary>
+constexpr std::size_t DIRECT_ALIGNMENT = 4096;
+
+#ifdef PASSWORD_MAKER_URING
+/// <summary>
+///		<para> Appends to the file through io_uring, the system calls are made directly so that liburing is not required. </para>
+///		<para> Bytes are copied into a ring of registered, preallocated and aligned slots, a full slot is submitted as one write </para>
+///		<para> and the next slot is filled while it is in flight, so the caller only waits when every slot is in flight. </para>
+///		<para> Every write but the last one is a full slot at an aligned offset, so the file may be opened with O_DIRECT, </para>
+///		<para> the last slot is padded then and the padding is truncated on finish. </para>
+///	</summary>
+class UringFile {
+public:
+	/// <summary> Constructor, the ring is set up and slots are registered. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when io_uring or its write operation is not supported or can not be set up. </exception>
+	/// <param name="descriptor"> The file descriptor, opened for writing at offset 0, it is not closed. </param>
+	/// <param name="direct">	  True if the file is opened with O_DIRECT. </param>
+	/// <param name="slots">	  Number of slots. </param>
+	/// <param name="slotSize">   Size of every slot, a multiple of the direct I/O alignment. </param>
+	UringFile(const int descriptor, const bool direct, const std::size_t slots, const std::size_t slotSize) :
+		_descriptor(descriptor),
+		_direct(direct),
+		_slotSize((slotSize + DIRECT_ALIGNMENT - 1) / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT),
+		_slots(std::max<std::size_t>(slots, 2)) {
+		io_uring_params params{};
+		_ring = static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(_slots.size() * 2), &params));
+		if (_ring < 0) {
+			throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+		}
+		try {
+			map_rings(params);
+			allocate_slots();
+			probe_write();
+		} catch (...) {
+			release();
+			throw;
+		}
+	}
+
+	/// <summary> Destructor, writes in flight are waited before slots are released. </summary>
+	~UringFile() {
+		while (_inFlight > 0 && reap(true)) {
+		}
+		release();
+	}
+
+	UringFile(const UringFile&) = delete;
+	UringFile& operator=(const UringFile&) = delete;
+
+	/// <summary> Appends the bytes, waits only while every slot is in flight. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="data"> The data. </param>
+	/// <param name="size"> The size. </param>
+	/// <returns> True if it succeeds, false if a write failed with errno set. </returns>
+	bool write(const char* data, std::size_t size) {
+		while (size > 0) {
+			if (_current == NO_SLOT && !acquire()) {
+				return false;
+			}
+			auto& slot = _slots[_current];
+			const auto copied = std::min(size, _slotSize - slot.length);
+			std::memcpy(slot.data + slot.length, data, copied);
+			slot.length += copied;
+			data += copied;
+			size -= copied;
+			if (slot.length == _slotSize) {
+				if (!submit(_current, _slotSize)) {
+					return false;
+				}
+				_current = NO_SLOT;
+			}
+		}
+		return true;
+	}
+
+	/// <summary> Submits the last slot and waits for all writes, the padding of direct I/O is truncated. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+	bool finish() {
+		std::uint64_t size = _offset;
+		if (_current != NO_SLOT && _slots[_current].length > 0) {
+			auto& slot = _slots[_current];
+			size += slot.length;
+			const auto length = _direct ? (slot.length + DIRECT_ALIGNMENT - 1) / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT : slot.length;
+			std::memset(slot.data + slot.length, 0, length - slot.length);
+			if (!submit(_current, length)) {
+				return false;
+			}
+		}
+		_current = NO_SLOT;
+		while (_inFlight > 0) {
+			if (!reap(true)) {
+				return false;
+			}
+		}
+		return _offset == size || ::ftruncate(_descriptor, static_cast<off_t>(size)) == 0;
+	}
+
+	/// <summary> Query if slots are registered with the ring, writes are fixed-buffer writes then. </summary>
+	bool registered() const { return _registered; }
+
+	/// <summary> Number of slots. </summary>
+	std::size_t slots() const { return _slots.size(); }
+
+	/// <summary> Number of times the caller waited for a slot. </summary>
+	std::uint64_t stalls() const { return _stalls; }
+
+private:
+	/// <summary> A slot of the ring. </summary>
+	using slot_t = struct {
+		char* data;
+		std::size_t length;		// Bytes filled or submitted
+		std::size_t written;	// Bytes written of a submitted slot
+		std::uint64_t offset;	// File offset of a submitted slot
+	};
+
+	/// <summary> Index of no slot. </summary>
+	static constexpr std::size_t NO_SLOT = static_cast<std::size_t>(-1);
+
+	/// <summary> Maps the submission queue, the completion queue and the submission entries. </summary>
+	/// <exception cref="std::runtime_error"> Thrown when mapping fails. </exception>
+	void map_rings(const io_uring_params& params) {
+		_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		_sqRing = ::mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQ_RING);
+		_cqRing = ::mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_CQ_RING);
+		_sqes = ::mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQES);
+		if (_sqRing == MAP_FAILED || _cqRing == MAP_FAILED || _sqes == MAP_FAILED) {
+			throw std::runtime_error(std::string("failed to map io_uring: ") + std::strerror(errno));
+		}
+		const auto sq = static_cast<char*>(_sqRing);
+		const auto cq = static_cast<char*>(_cqRing);
+		_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+		_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+		_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+		_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+		_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+		_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+		_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+	}
+
+	/// <summary> Allocates aligned slots and registers them, writes fall back to plain buffers if registering fails. </summary>
+	/// <exception cref="std::runtime_error"> Thrown when allocation fails. </exception>
+	void allocate_slots() {
+		std::vector<iovec> vectors;
+		for (std::size_t i = 0; i < _slots.size(); i++) {
+			void* data = nullptr;
+			if (::posix_memalign(&data, DIRECT_ALIGNMENT, _slotSize) != 0) {
+				throw std::runtime_error("failed to allocate io_uring slots");
+			}
+			_slots[i] = { static_cast<char*>(data), 0, 0, 0 };
+			_free.push_back(i);
+			vectors.push_back({ data, _slotSize });
+		}
+		// Registered slots are pinned once instead of on every write, it may exceed the locked memory limit
+		_registered = ::syscall(__NR_io_uring_register, _ring, IORING_REGISTER_BUFFERS, vectors.data(), static_cast<unsigned>(vectors.size())) == 0;
+	}
+
+	/// <summary>
+	///		<para> Checks that the kernel supports the write operation used, io_uring of kernels before 5.6 has no plain write </para>
+	///		<para> and no probe either, only the fixed-buffer write is used then. </para>
+	///	</summary>
+	/// <exception cref="std::runtime_error"> Thrown when the write operation is not supported. </exception>
+	void probe_write() const {
+		const auto opcode = _registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+		std::vector<char> buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+		auto probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+		if (::syscall(__NR_io_uring_register, _ring, IORING_REGISTER_PROBE, probe, 256) != 0) {
+			if (_registered) {
+				return;
+			}
+			throw std::runtime_error("io_uring of this kernel does not support IORING_OP_WRITE");
+		}
+		if (opcode > probe->last_op || (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) == 0) {
+			throw std::runtime_error(std::string("io_uring of this kernel does not support ") + (_registered ? "IORING_OP_WRITE_FIXED" : "IORING_OP_WRITE"));
+		}
+	}
+
+	/// <summary> Unmaps the rings, closes the ring and frees slots. </summary>
+	void release() {
+		if (_sqes != nullptr && _sqes != MAP_FAILED) {
+			::munmap(_sqes, _sqesSize);
+		}
+		if (_cqRing != nullptr && _cqRing != MAP_FAILED) {
+			::munmap(_cqRing, _cqRingSize);
+		}
+		if (_sqRing != nullptr && _sqRing != MAP_FAILED) {
+			::munmap(_sqRing, _sqRingSize);
+		}
+		_sqes = _cqRing = _sqRing = nullptr;
+		if (_ring >= 0) {
+			::close(_ring);
+			_ring = -1;
+		}
+		for (auto& slot : _slots) {
+			std::free(slot.data);
+			slot.data = nullptr;
+		}
+	}
+
+	/// <summary> Takes a free slot as the current one, waits for a completion if none is free. </summary>
+	/// <returns> True if it succeeds, false if a write failed with errno set. </returns>
+	bool acquire() {
+		if (_free.empty()) {
+			_stalls++;
+		}
+		while (_free.empty()) {
+			if (!reap(true)) {
+				return false;
+			}
+		}
+		_current = _free.back();
+		_free.pop_back();
+		_slots[_current].length = 0;
+		return true;
+	}
+
+	/// <summary> Submits the slot as a write at the end of the file. </summary>
+	/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+	bool submit(const std::size_t index, const std::size_t length) {
+		auto& slot = _slots[index];
+		slot.length = length;
+		slot.written = 0;
+		slot.offset = _offset;
+		_offset += length;
+		_inFlight++;
+		enqueue(index);
+		return enter(0) && reap(false);
+	}
+
+	/// <summary> Queues the write of the rest of the slot, the ring holds twice as many entries as slots so it is never full. </summary>
+	void enqueue(const std::size_t index) {
+		const auto& slot = _slots[index];
+		const auto tail = *_sqTail;
+		const auto position = tail & _sqMask;
+		auto& entry = static_cast<io_uring_sqe*>(_sqes)[position];
+		std::memset(&entry, 0, sizeof(entry));
+		entry.opcode = static_cast<std::uint8_t>(_registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE);
+		entry.fd = _descriptor;
+		entry.addr = reinterpret_cast<std::uint64_t>(slot.data + slot.written);
+		entry.len = static_cast<std::uint32_t>(slot.length - slot.written);
+		entry.off = slot.offset + slot.written;
+		entry.buf_index = static_cast<std::uint16_t>(_registered ? index : 0);
+		entry.user_data = index;
+		_sqArray[position] = position;
+		// The kernel must see the entry before the new tail
+		__atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+	}
+
+	/// <summary> Submits queued entries and waits for completions. </summary>
+	/// <param name="wait"> Number of completions to wait for. </param>
+	/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+	bool enter(const unsigned wait) {
+		while (true) {
+			const auto consumed = ::syscall(__NR_io_uring_enter, _ring, *_sqTail - _submitted, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+			if (consumed >= 0) {
+				_submitted += static_cast<unsigned>(consumed);
+				return true;
+			}
+			if (errno != EINTR && errno != EAGAIN) {
+				return false;
+			}
+		}
+	}
+
+	/// <summary> Handles completions, short writes are resubmitted and finished slots are freed, a short direct write that ends unaligned fails. </summary>
+	/// <param name="wait"> True to wait for a completion first. </param>
+	/// <returns> True if it succeeds, false if a write failed with errno set. </returns>
+	bool reap(const bool wait) {
+		if (wait && !enter(1)) {
+			return false;
+		}
+		auto head = *_cqHead;
+		const auto tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+		auto succeed = true;
+		for (; head != tail; head++) {
+			const auto& completion = _cqes[head & _cqMask];
+			const auto index = static_cast<std::size_t>(completion.user_data);
+			auto& slot = _slots[index];
+			if (completion.res < 0 && completion.res != -EINTR && completion.res != -EAGAIN) {
+				errno = -completion.res;
+				succeed = false;
+				_inFlight--;
+				_free.push_back(index);
+				continue;
+			}
+			slot.written += completion.res > 0 ? static_cast<std::size_t>(completion.res) : 0;
+			// The rest of a short direct write is resubmitted only at an aligned offset
+			if (slot.written < slot.length && completion.res != 0 && (!_direct || slot.written % DIRECT_ALIGNMENT == 0)) {
+				enqueue(index);
+				continue;
+			}
+			if (slot.written < slot.length) {
+				errno = EIO;
+				succeed = false;
+			}
+			_inFlight--;
+			_free.push_back(index);
+		}
+		__atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+		// Rests of short writes are queued again
+		return succeed && (*_sqTail == _submitted || enter(0));
+	}
+
+	int _descriptor;
+	bool _direct;
+	std::size_t _slotSize;
+	std::vector<slot_t> _slots;
+	std::vector<std::size_t> _free;
+	std::size_t _current{ NO_SLOT };
+	std::size_t _inFlight{ 0 };
+	std::uint64_t _offset{ 0 };
+	std::uint64_t _stalls{ 0 };
+	bool _registered{ false };
+	int _ring{ -1 };
+	void* _sqRing{ nullptr };
+	void* _cqRing{ nullptr };
+	void* _sqes{ nullptr };
+	std::size_t _sqRingSize{ 0 };
+	std::size_t _cqRingSize{ 0 };
+	std::size_t _sqesSize{ 0 };
+	unsigned* _sqTail{ nullptr };
+	unsigned _sqMask{ 0 };
+	unsigned* _sqArray{ nullptr };
+	unsigned* _cqHead{ nullptr };
+	unsigned* _cqTail{ nullptr };
+	unsigned _cqMask{ 0 };
+	io_uring_cqe* _cqes{ nullptr };
+	unsigned _submitted{ 0 };
+};
+#else
+/// <summary> Placeholder where io_uring is not supported, construction always fails so that writers fall back. </summary>
+class UringFile {
+public:
+	UringFile(const int, const bool, const std::size_t, const std::size_t) {
+		throw std::runtime_error("io_uring is not supported on this platform");
+	}
+	bool write(const char*, std::size_t) { return false; }
+	bool finish() { return false; }
+	bool registered() const { return false; }
+	std::size_t slots() const { return 0; }
+	std::uint64_t stalls() const { return 0; }
+};
+#endif
+}	// namespace bwt
@@ -0,0 +1,287 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PASSWORD_MAKER_UTF8_SSE2
+#endif
+
+namespace bwt {
+namespace utf8 {
+/// <summary> Byte order mark of UTF-8. </summary>
+constexpr const char* BOM = "\xEF\xBB\xBF";
+
+/// <summary> Skips leading ASCII bytes, 16 bytes at a time when SSE2 is available. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="begin"> The begin of the data. </param>
+/// <param name="end">   The end of the data. </param>
+/// <returns> Pointer to the first non-ASCII byte, end if the data is ASCII only. </returns>
+inline const char* skip_ascii(const char* begin, const char* end) {
+#ifdef PASSWORD_MAKER_UTF8_SSE2
+	for (; end - begin >= 16; begin += 16) {
+		const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+		const auto mask = _mm_movemask_epi8(block);
+		if (mask != 0) {
+			// Index of the first byte with high bit set
+			unsigned offset = 0;
+			while (((mask >> offset) & 1) == 0) {
+				offset++;
+			}
+			return begin + offset;
+		}
+	}
+#endif
+	for (; begin != end && static_cast<unsigned char>(*begin) < 0x80; begin++) {}
+	return begin;
+}
+
+/// <summary> Query if the data is ASCII only. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="data">   The data. </param>
+/// <param name="length"> The length. </param>
+/// <returns> True if there is no byte greater than 0x7F. </returns>
+inline bool is_ascii(const char* data, const std::size_t length) {
+	return skip_ascii(data, data + length) == data + length;
+}
+
+/// <summary> Query if the string is ASCII only. </summary>
+inline bool is_ascii(const std::string& data) { return is_ascii(data.data(), data.size()); }
+
+/// <summary> Validates the UTF-8 data, ASCII runs are skipped by skip_ascii(). </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="data">   The data. </param>
+/// <param name="length"> The length. </param>
+/// <returns> True if it is well-formed UTF-8 without overlong forms and surrogates. </returns>
+inline bool validate(const char* data, const std::size_t length) {
+	const auto end = data + length;
+	for (auto it = skip_ascii(data, end); it != end; it = skip_ascii(it, end)) {
+		const auto lead = static_cast<unsigned char>(*it);
+		std::size_t sequence = 0;
+		unsigned char lower = 0x80;
+		unsigned char upper = 0xBF;
+		if (lead >= 0xC2 && lead <= 0xDF) {
+			sequence = 2;
+		} else if (lead >= 0xE0 && lead <= 0xEF) {
+			sequence = 3;
+			lower = (lead == 0xE0) ? 0xA0 : 0x80;
+			upper = (lead == 0xED) ? 0x9F : 0xBF;
+		} else if (lead >= 0xF0 && lead <= 0xF4) {
+			sequence = 4;
+			lower = (lead == 0xF0) ? 0x90 : 0x80;
+			upper = (lead == 0xF4) ? 0x8F : 0xBF;
+		} else {
+			return false;
+		}
+		if (static_cast<std::size_t>(end - it) < sequence) {
+			return false;
+		}
+		const auto second = static_cast<unsigned char>(it[1]);
+		if (second < lower || second > upper) {
+			return false;
+		}
+		for (std::size_t i = 2; i < sequence; i++) {
+			if ((static_cast<unsigned char>(it[i]) & 0xC0) != 0x80) {
+				return false;
+			}
+		}
+		it += sequence;
+	}
+	return true;
+}
+
+/// <summary> Validates the UTF-8 string. </summary>
+inline bool validate(const std::string& data) { return validate(data.data(), data.size()); }
+
+/// <summary> Appends the code point encoded in UTF-8. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="codePoint"> The code point. </param>
+/// <param name="output">    [in,out] The output. </param>
+inline void encode(const std::uint32_t codePoint, std::string& output) {
+	if (codePoint < 0x80) {
+		output += static_cast<char>(codePoint);
+	} else if (codePoint < 0x800) {
+		output += static_cast<char>(0xC0 | (codePoint >> 6));
+		output += static_cast<char>(0x80 | (codePoint & 0x3F));
+	} else if (codePoint < 0x10000) {
+		output += static_cast<char>(0xE0 | (codePoint >> 12));
+		output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		output += static_cast<char>(0x80 | (codePoint & 0x3F));
+	} else {
+		output += static_cast<char>(0xF0 | (codePoint >> 18));
+		output += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+		output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		output += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+}
+
+/// <summary> Decodes one code point of validated UTF-8 data. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="it">  [in,out] The position, advanced to the next code point. </param>
+/// <param name="end"> The end of the data. </param>
+/// <returns> The code point. </returns>
+inline std::uint32_t decode(const char*& it, const char* end) {
+	const auto lead = static_cast<unsigned char>(*it++);
+	if (lead < 0x80) {
+		return lead;
+	}
+	const std::size_t sequence = (lead >= 0xF0) ? 4 : ((lead >= 0xE0) ? 3 : 2);
+	std::uint32_t codePoint = lead & (0x7F >> sequence);
+	for (std::size_t i = 1; i < sequence && it != end; i++) {
+		codePoint = (codePoint << 6) | (static_cast<unsigned char>(*it++) & 0x3F);
+	}
+	return codePoint;
+}
+
+/// <summary> Gets the byte length of the sequence started by the lead byte. </summary>
+inline std::size_t sequence_length(const char lead) {
+	const auto byte = static_cast<unsigned char>(lead);
+	return (byte < 0x80) ? 1 : ((byte >= 0xF0) ? 4 : ((byte >= 0xE0) ? 3 : 2));
+}
+
+/// <summary> Counts the code points of validated UTF-8 data. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="data">   The data. </param>
+/// <param name="length"> The length. </param>
+/// <returns> Number of code points. </returns>
+inline std::size_t code_points(const char* data, const std::size_t length) {
+	return static_cast<std::size_t>(std::count_if(data, data + length, [](const char ch) {
+		return (static_cast<unsigned char>(ch) & 0xC0) != 0x80; }));
+}
+
+/// <summary> Gets the byte offset after the first count code points of validated UTF-8 data. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="data">   The data. </param>
+/// <param name="length"> The length. </param>
+/// <param name="count">  Number of code points. </param>
+/// <returns> The byte offset, length if there are fewer code points. </returns>
+inline std::size_t offset_of(const char* data, const std::size_t length, std::size_t count) {
+	std::size_t offset = 0;
+	for (; offset < length && count > 0; count--) {
+		offset += sequence_length(data[offset]);
+	}
+	return std::min(offset, length);
+}
+
+/// <summary> Reverses the code points of validated UTF-8 data in place. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="begin"> The begin of the data. </param>
+/// <param name="end">   The end of the data. </param>
+inline void reverse(char* begin, char* end) {
+	// Reverse every multi-byte sequence first, then the whole range restores their byte order
+	for (auto it = begin; it < end;) {
+		const auto sequence = std::min<std::size_t>(sequence_length(*it), static_cast<std::size_t>(end - it));
+		std::reverse(it, it + sequence);
+		it += sequence;
+	}
+	std::reverse(begin, end);
+}
+
+/// <summary> Transcodes ISO-8859-1 data to UTF-8. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="data"> The data. </param>
+/// <returns> The UTF-8 data. </returns>
+inline std::string from_latin1(const std::string& data) {
+	std::string output;
+	output.reserve(data.size() * 2);
+	std::for_each(data.cbegin(), data.cend(), [&](const char ch) { encode(static_cast<unsigned char>(ch), output); });
+	return output;
+}
+
+/// <summary> Query if the code point is a lower case letter of Latin Extended-A. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="codePoint"> The code point in [0x100, 0x17F]. </param>
+/// <returns> True if it is lower case. </returns>
+inline bool is_latin_extended_lower(const std::uint32_t codePoint) {
+	if (codePoint == 0x138 || codePoint == 0x149 || codePoint == 0x17F) {
+		return true;
+	}
+	if (codePoint == 0x178) {
+		return false;
+	}
+	// Upper and lower case letters are paired, the upper one is odd only in these two ranges
+	const bool oddIsUpper = (codePoint >= 0x139 && codePoint <= 0x148) || (codePoint >= 0x179 && codePoint <= 0x17E);
+	return (codePoint & 1) != (oddIsUpper ? 1u : 0u);
+}
+
+/// <summary> Query if the code point is a lower case letter, covers Latin-1, Latin Extended-A, Greek and Cyrillic. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="codePoint"> The code point. </param>
+/// <returns> True if it is lower case. </returns>
+inline bool is_lower(const std::uint32_t codePoint) {
+	if (codePoint < 0x80) {
+		return codePoint >= 'a' && codePoint <= 'z';
+	}
+	return (codePoint >= 0xDF && codePoint <= 0xFF && codePoint != 0xF7) ||
+		(codePoint >= 0x100 && codePoint <= 0x17F && is_latin_extended_lower(codePoint)) ||
+		(codePoint >= 0x3B1 && codePoint <= 0x3C9) ||
+		(codePoint >= 0x430 && codePoint <= 0x45F);
+}
+
+/// <summary> Query if the code point is an upper case letter, covers Latin-1, Latin Extended-A, Greek and Cyrillic. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="codePoint"> The code point. </param>
+/// <returns> True if it is upper case. </returns>
+inline bool is_upper(const std::uint32_t codePoint) {
+	if (codePoint < 0x80) {
+		return codePoint >= 'A' && codePoint <= 'Z';
+	}
+	return (codePoint >= 0xC0 && codePoint <= 0xDE && codePoint != 0xD7) ||
+		(codePoint >= 0x100 && codePoint <= 0x17F && !is_latin_extended_lower(codePoint)) ||
+		(codePoint >= 0x391 && codePoint <= 0x3A9 && codePoint != 0x3A2) ||
+		(codePoint >= 0x400 && codePoint <= 0x42F);
+}
+
+/// <summary> Converts the code point to upper case, covers Latin-1, Latin Extended-A, Greek and Cyrillic. </summary>
+/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+/// <param name="codePoint"> The code point. </param>
+/// <returns> The upper case code point, or itself if there is none. </returns>
+inline std::uint32_t to_upper(const std::uint32_t codePoint) {
+	if (!is_lower(codePoint) || codePoint == 0xDF || codePoint == 0x138 || codePoint == 0x149 || codePoint == 0x17F || codePoint == 0x3C2) {
+		return codePoint;
+	}
+	if (codePoint < 0x80 || (codePoint >= 0xE0 && codePoint <= 0xFE) || (codePoint >= 0x3B1 && codePoint <= 0x3C9) || (codePoint >= 0x430 && codePoint <= 0x44F)) {
+		return codePoint - 0x20;
+	}
+	if (codePoint == 0xFF) {
+		return 0x178;
+	}
+	if (codePoint >= 0x450 && codePoint <= 0x45F) {
+		return codePoint - 0x50;
+	}
+	return codePoint - 1;
+}
+}	// namespace utf8
+}	// namespace bwt
@@ -5,9 +5,9 @@
 #define PASSWORD_MAKER_VERSION_PATCH	4
 #define PASSWORD_MAKER_VERSION			"0.0.4"
 
-#define CMAKE_COMPILER					"MSVC"
-#define CMAKE_COMPILER_VERSION			"19.25.28614.0"
-#define CMAKE_VERSION					"3.17.1"
-#define CMAKE_COMPILE_DATE				"2020-04-21"
-#define CMAKE_SYSTEM					"Windows"
-#define CMAKE_SYSTEM_VERSION			"10.0.18363"
+#define CMAKE_COMPILER					"GNU"
+#define CMAKE_COMPILER_VERSION			"12.2.0"
+#define CMAKE_VERSION					"3.25.1"
+#define CMAKE_COMPILE_DATE				"2026-10-19"
+#define CMAKE_SYSTEM					"Linux"
+#define CMAKE_SYSTEM_VERSION			"6.18.44-fc-v139"
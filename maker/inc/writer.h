@@ -0,0 +1,892 @@
+﻿#pragma once
+
+/*++
+
+Copyright Notice
+
+MIT License
+
+Copyright (C) 2020 BlueWingTan. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+--*/
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <map>
+#include <limits>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <condition_variable>
+
+#include <csignal>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#endif
+
+#include <compress.h>
+#include <indexed.h>
+#include <uring.h>
+#include <server.h>
+
+namespace bwt {
+/// <summary> File descriptor of the standard output. </summary>
+constexpr int STDOUT_DESCRIPTOR = 1;
+
+/// <summary> Size of the output buffer handed to the writer. </summary>
+constexpr std::size_t OUTPUT_BUFFER_SIZE = std::size_t(4) << 20;
+
+namespace detail {
+/// <summary> Opens the file for writing, it is truncated. </summary>
+/// <param name="path">   The file path. </param>
+/// <param name="direct"> True to bypass the page cache with O_DIRECT where supported. </param>
+/// <returns> The file descriptor, -1 if it fails. </returns>
+inline int open_output(const std::string& path, const bool direct = false) {
+#ifdef _WIN32
+	(void)direct;
+	return ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#elif defined(O_DIRECT)
+	return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | (direct ? O_DIRECT : 0), 0644);
+#else
+	(void)direct;
+	return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+/// <summary> Writes all bytes, short writes and interrupts are retried. </summary>
+/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+inline bool write_all(const int descriptor, const char* data, std::size_t size) {
+	while (size > 0) {
+#ifdef _WIN32
+		const auto written = ::_write(descriptor, data, static_cast<unsigned int>(std::min<std::size_t>(size, 1u << 30)));
+#else
+		const auto written = ::write(descriptor, data, size);
+#endif
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		size -= static_cast<std::size_t>(written);
+	}
+	return true;
+}
+
+/// <summary> Writes all bytes at the offset without moving the file position, short writes and interrupts are retried. </summary>
+/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+inline bool write_all_at(const int descriptor, const char* data, std::size_t size, std::uint64_t offset) {
+#ifdef _WIN32
+	// There is no positional write, seek and write under a lock instead
+	static std::mutex lock;
+	std::lock_guard<std::mutex> guard(lock);
+	return ::_lseeki64(descriptor, static_cast<__int64>(offset), SEEK_SET) >= 0 && write_all(descriptor, data, size);
+#else
+	while (size > 0) {
+		const auto written = ::pwrite(descriptor, data, size, static_cast<off_t>(offset));
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		size -= static_cast<std::size_t>(written);
+		offset += static_cast<std::uint64_t>(written);
+	}
+	return true;
+#endif
+}
+
+/// <summary> Allocates the file to the size, the file is only extended if the file system can not preallocate. </summary>
+/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+inline bool preallocate(const int descriptor, const std::uint64_t size) {
+#ifdef _WIN32
+	return ::_chsize_s(descriptor, static_cast<__int64>(size)) == 0;
+#else
+#ifdef __linux__
+	const auto result = ::posix_fallocate(descriptor, 0, static_cast<off_t>(size));
+	if (result == 0) {
+		return true;
+	}
+	if (result != EINVAL && result != EOPNOTSUPP) {
+		errno = result;
+		return false;
+	}
+#endif
+	return ::ftruncate(descriptor, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+/// <summary> Gets the capacity of the pipe, enlarged if possible. </summary>
+/// <returns> The capacity in bytes, 0 if the descriptor is not a pipe or pages can not be spliced into it. </returns>
+inline std::size_t pipe_capacity(const int descriptor) {
+#ifdef __linux__
+	struct stat status;
+	if (::fstat(descriptor, &status) != 0 || !S_ISFIFO(status.st_mode)) {
+		return 0;
+	}
+	// Best effort, an unprivileged process may be limited to a smaller pipe
+	::fcntl(descriptor, F_SETPIPE_SZ, 1 << 20);
+	const auto capacity = ::fcntl(descriptor, F_GETPIPE_SZ);
+	return capacity > 0 ? static_cast<std::size_t>(capacity) : 0;
+#else
+	(void)descriptor;
+	return 0;
+#endif
+}
+
+/// <summary> Splices all bytes into the pipe by mapping their pages, interrupts are retried. </summary>
+/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+inline bool splice_all(const int descriptor, const char* data, std::size_t size) {
+#ifdef __linux__
+	while (size > 0) {
+		iovec vector{ const_cast<char*>(data), size };
+		const auto spliced = ::vmsplice(descriptor, &vector, 1, 0);
+		if (spliced < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += spliced;
+		size -= static_cast<std::size_t>(spliced);
+	}
+	return true;
+#else
+	return write_all(descriptor, data, size);
+#endif
+}
+
+/// <summary> Gets the path of a rotated file, the zero-padded index is inserted before the extension of text. </summary>
+/// <param name="path">  The output file path. </param>
+/// <param name="index"> The index of the rotated file. </param>
+/// <returns> The path. </returns>
+inline std::string rotated_path(const std::string& path, const std::size_t index) {
+	const auto name = path.find_last_of("/\\") + 1;
+	auto dot = path.rfind(".txt");
+	dot = (dot == std::string::npos || dot < name) ? path.find('.', name) : dot;
+	auto number = std::to_string(index);
+	number.insert(0, number.size() < 4 ? 4 - number.size() : 0, '0');
+	return dot == std::string::npos ? path + "." + number : path.substr(0, dot) + "." + number + path.substr(dot);
+}
+
+/// <summary> Gets the size of the longest run of whole lines at the start of the data within the limits. </summary>
+/// <param name="data">		  The line feed terminated data. </param>
+/// <param name="size">		  Size of the data. </param>
+/// <param name="bytes">	  Most bytes taken. </param>
+/// <param name="lines">	  Most lines taken. </param>
+/// <param name="atLeastOne"> Take the first line even if it exceeds the limits. </param>
+/// <param name="taken">	  [out] Number of lines taken. </param>
+/// <returns> Number of bytes taken. </returns>
+inline std::size_t fit_lines(const char* data, const std::size_t size, const std::uint64_t bytes, const std::uint64_t lines, const bool atLeastOne, std::uint64_t& taken) {
+	std::size_t end = 0;
+	taken = 0;
+	while (end < size && taken < std::max<std::uint64_t>(lines, atLeastOne ? 1 : 0)) {
+		const auto next = static_cast<const char*>(std::memchr(data + end, '\n', size - end));
+		const auto length = next == nullptr ? size : static_cast<std::size_t>(next - data) + 1;
+		if (length > bytes && !(atLeastOne && taken == 0)) {
+			break;
+		}
+		end = length;
+		taken++;
+	}
+	return end;
+}
+
+/// <summary> Closes the file. </summary>
+/// <returns> True if it succeeds. </returns>
+inline bool close_output(const int descriptor) {
+#ifdef _WIN32
+	return ::_close(descriptor) == 0;
+#else
+	return ::close(descriptor) == 0;
+#endif
+}
+}	// namespace detail
+
+/// <summary>
+///		<para> Writer of a preallocated file, every caller writes its own range at a known offset. </para>
+///		<para> Ranges never overlap, so callers write fully in parallel and the output does not depend on their order. </para>
+///	</summary>
+class PositionalWriter {
+public:
+	/// <summary> Constructor, the file is truncated and preallocated. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the file can not be opened or preallocated. </exception>
+	/// <param name="path"> The output file path. </param>
+	/// <param name="size"> The final size of the file. </param>
+	PositionalWriter(const std::string& path, const std::uint64_t size) :
+		_path(path),
+		_size(size),
+		_descriptor(detail::open_output(path)),
+		_start(std::chrono::steady_clock::now()) {
+		if (_descriptor < 0) {
+			throw std::runtime_error("failed to open " + path + ": " + std::strerror(errno));
+		}
+		if (!detail::preallocate(_descriptor, size)) {
+			const std::string error = std::strerror(errno);
+			detail::close_output(_descriptor);
+			throw std::runtime_error("failed to preallocate " + std::to_string(size) + " byte(s) for " + path + ": " + error);
+		}
+	}
+
+	/// <summary> Destructor. </summary>
+	~PositionalWriter() {
+		if (_descriptor >= 0) {
+			detail::close_output(_descriptor);
+		}
+	}
+
+	PositionalWriter(const PositionalWriter&) = delete;
+	PositionalWriter& operator=(const PositionalWriter&) = delete;
+
+	/// <summary> Writes the data at the offset, thread-safe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when it exceeds the file size or can not be written. </exception>
+	/// <param name="data">   The data. </param>
+	/// <param name="size">   The data size. </param>
+	/// <param name="offset"> The offset in the file. </param>
+	void write(const char* data, const std::size_t size, const std::uint64_t offset) {
+		if (offset + size > _size) {
+			throw std::runtime_error("write beyond the preallocated size of " + _path);
+		}
+		if (!detail::write_all_at(_descriptor, data, size, offset)) {
+			throw std::runtime_error("failed to write " + _path + ": " + std::strerror(errno));
+		}
+		_bytes += size;
+	}
+
+	/// <summary> Closes the file. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the file can not be closed. </exception>
+	void close() {
+		if (_descriptor < 0) {
+			return;
+		}
+		_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+		const auto succeed = detail::close_output(_descriptor);
+		_descriptor = -1;
+		if (!succeed) {
+			throw std::runtime_error("failed to close " + _path + ": " + std::strerror(errno));
+		}
+	}
+
+	/// <summary> Number of bytes written. </summary>
+	std::uint64_t bytes() const { return _bytes; }
+
+	/// <summary> Seconds from open to close. </summary>
+	double elapsed() const { return _elapsed; }
+
+private:
+	std::string _path;
+	std::uint64_t _size;
+	int _descriptor;
+	std::chrono::steady_clock::time_point _start;
+	std::atomic<std::uint64_t> _bytes{ 0 };
+	double _elapsed{ 0 };
+};
+
+/// <summary> A file written by the output writer. </summary>
+struct output_file_t {
+	std::string path;
+	std::uint64_t lines;
+	std::uint64_t bytes;
+};
+
+/// <summary> Options of the output writer. </summary>
+struct WriterOption {
+	/// <summary> Compression of buffers. </summary>
+	compression_t compression{ compression_t::NONE };
+	/// <summary> Format of the file. </summary>
+	output_format_t format{ output_format_t::TEXT };
+	/// <summary> Backend of writes. </summary>
+	io_backend_t backend{ io_backend_t::BUFFERED };
+	/// <summary> Open the file with O_DIRECT if it is written through io_uring. </summary>
+	bool direct{ false };
+	/// <summary> Switch to the next file before it exceeds this many bytes, 0 for no limit. </summary>
+	std::uint64_t rotateBytes{ 0 };
+	/// <summary> Switch to the next file before it exceeds this many lines, 0 for no limit. </summary>
+	std::uint64_t rotateLines{ 0 };
+	/// <summary> Called on the writer thread with every file closed by rotation. </summary>
+	std::function<void(const output_file_t&)> rotated;
+};
+
+/// <summary>
+///		<para> Writer stage of the output, workers hand off filled buffers through a bounded queue. </para>
+///		<para> One thread keeps the file open and writes every buffer with a single large write, </para>
+///		<para> written buffers are recycled so that workers do not reallocate them. </para>
+///		<para> Buffers tagged with sequence numbers pass a bounded reorder buffer and are written strictly in order. </para>
+///		<para> Buffers are compressed or encoded into blocks by the workers that hand them off, so the writer only writes. </para>
+///		<para> Blocks of the indexed format are recorded by the writer, their index and footer are written on close. </para>
+///		<para> Files may be written through io_uring instead of write(2), it falls back to write(2) where io_uring is not supported. </para>
+///		<para> Files may be rotated by the writer thread at line boundaries inside buffers, so workers never pause and every file ends with a whole line. </para>
+///		<para> Buffers may be handed to a chunk server instead of a file, each one becomes a chunk for a single client. </para>
+///	</summary>
+class OutputWriter {
+public:
+	/// <summary> Constructor, the file is truncated and the writer thread is started. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the file can not be opened. </exception>
+	/// <param name="path">	  The output file path, the index of the file is inserted into it if files are rotated. </param>
+	/// <param name="depth">  Number of buffers the queue holds before workers wait. </param>
+	/// <param name="option"> The options. </param>
+	OutputWriter(const std::string& path, const std::size_t depth, const WriterOption& option = WriterOption()) :
+		_basePath(path),
+		_path(option.rotateBytes > 0 || option.rotateLines > 0 ? detail::rotated_path(path, 0) : path),
+		_depth(std::max<std::size_t>(depth, 1)),
+		_compression(option.compression),
+		_format(option.format),
+		_rotateBytes(option.rotateBytes),
+		_rotateLines(option.rotateLines),
+		_rotated(option.rotated),
+		_descriptor(detail::open_output(_path, option.backend == io_backend_t::URING && option.direct)),
+		_start(std::chrono::steady_clock::now()) {
+		if (_descriptor < 0 && option.backend == io_backend_t::URING && option.direct && errno == EINVAL) {
+			_fallback = "O_DIRECT is not supported by the file system";
+			_descriptor = detail::open_output(_path);
+		}
+		if (_descriptor < 0) {
+			throw std::runtime_error("failed to open " + _path + ": " + std::strerror(errno));
+		}
+		if (_format == output_format_t::INDEXED && (_compression != compression_t::NONE || _rotateBytes > 0 || _rotateLines > 0)) {
+			detail::close_output(_descriptor);
+			throw std::runtime_error("indexed file " + _path + " can not be compressed or rotated");
+		}
+		if (option.backend == io_backend_t::URING) {
+			open_uring(option.direct && _fallback.empty());
+		}
+		if (_format == output_format_t::INDEXED) {
+			if (!output(INDEXED_MAGIC, INDEXED_MAGIC_SIZE)) {
+				const auto error = "failed to write " + _path + ": " + std::strerror(errno);
+				detail::close_output(_descriptor);
+				throw std::runtime_error(error);
+			}
+			_bytes = INDEXED_MAGIC_SIZE;
+			_fileBytes = INDEXED_MAGIC_SIZE;
+		}
+		_thread = std::thread(&OutputWriter::run, this);
+	}
+
+	/// <summary> Constructor of a stream that is already open, such as the standard output. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="descriptor"> The file descriptor, it is not closed. </param>
+	/// <param name="name">		  The name of the stream. </param>
+	/// <param name="depth">	  Number of buffers the queue holds before workers wait. </param>
+	/// <param name="compression"> The compression of buffers. </param>
+	OutputWriter(const int descriptor, const std::string& name, const std::size_t depth, const compression_t compression = compression_t::NONE) :
+		_basePath(name),
+		_path(name),
+		_depth(std::max<std::size_t>(depth, 1)),
+		_compression(compression),
+		_descriptor(descriptor),
+		_owned(false),
+		_pipeCapacity(detail::pipe_capacity(descriptor)),
+		_start(std::chrono::steady_clock::now()) {
+#ifdef _WIN32
+		::_setmode(descriptor, _O_BINARY);
+#else
+		// A consumer closing the stream fails writes with EPIPE instead of killing the process
+		std::signal(SIGPIPE, SIG_IGN);
+#endif
+		_thread = std::thread(&OutputWriter::run, this);
+	}
+
+	/// <summary> Constructor of a writer that hands buffers to the chunk server instead of writing them. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <param name="server">	   The chunk server, it must outlive the writer and is not closed. </param>
+	/// <param name="depth">	   Number of buffers the queue holds before workers wait. </param>
+	/// <param name="compression"> The compression of buffers. </param>
+	OutputWriter(ChunkServer& server, const std::size_t depth, const compression_t compression = compression_t::NONE) :
+		_basePath(server.address()),
+		_path(server.address()),
+		_depth(std::max<std::size_t>(depth, 1)),
+		_compression(compression),
+		_descriptor(-1),
+		_server(&server),
+		_owned(false),
+		_start(std::chrono::steady_clock::now()) {
+		_thread = std::thread(&OutputWriter::run, this);
+	}
+
+	/// <summary> Destructor, buffers still queued are written. </summary>
+	~OutputWriter() {
+		try {
+			close();
+		} catch (...) {
+		}
+	}
+
+	OutputWriter(const OutputWriter&) = delete;
+	OutputWriter& operator=(const OutputWriter&) = delete;
+
+	/// <summary> Gets an empty buffer, recycled from written ones if possible, thread-safe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <returns> The buffer. </returns>
+	std::string acquire() {
+		std::string buffer;
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			if (!_free.empty()) {
+				buffer.swap(_free.back());
+				_free.pop_back();
+			}
+		}
+		buffer.clear();
+		buffer.reserve(OUTPUT_BUFFER_SIZE + (OUTPUT_BUFFER_SIZE >> 2));
+		return buffer;
+	}
+
+	/// <summary> Hands off the buffer to the writer, waits while the queue is full, thread-safe. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the writer failed. </exception>
+	/// <param name="buffer"> [in,out] The buffer, replaced by an empty one. </param>
+	void push(std::string& buffer) {
+		if (buffer.empty()) {
+			return;
+		}
+		std::vector<std::pair<std::size_t, std::uint64_t>> pieces;
+		const auto lines = encode(buffer, pieces);
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			if (_queue.size() >= _depth) {
+				const auto start = std::chrono::steady_clock::now();
+				_notFull.wait(lock, [&]() { return _queue.size() < _depth || !_error.empty(); });
+				_waited += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+			if (!_error.empty()) {
+				throw std::runtime_error(_error);
+			}
+			_queue.emplace_back();
+			_queue.back().data.swap(buffer);
+			_queue.back().lines = lines;
+			_queue.back().pieces.swap(pieces);
+		}
+		_notEmpty.notify_one();
+		buffer = acquire();
+	}
+
+	/// <summary>
+	///		<para> Hands off the buffer tagged with its sequence number, it is written after all buffers of lower numbers, thread-safe. </para>
+	///		<para> Workers more than the depth ahead of the next number to write wait, so that the reorder buffer is bounded. </para>
+	///	</summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the writer failed. </exception>
+	/// <param name="buffer">   [in,out] The buffer, may be empty, replaced by an empty one. </param>
+	/// <param name="sequence"> The sequence number, every number from 0 must be pushed exactly once. </param>
+	void push(std::string& buffer, const std::uint64_t sequence) {
+		std::vector<std::pair<std::size_t, std::uint64_t>> pieces;
+		const auto lines = encode(buffer, pieces);
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			// The buffer of the next number is never held back by the reorder window
+			const auto admitted = [&]() { return (sequence < _released + _depth && _queue.size() < _depth) || !_error.empty(); };
+			if (!admitted()) {
+				const auto start = std::chrono::steady_clock::now();
+				_notFull.wait(lock, admitted);
+				_waited += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+			if (!_error.empty()) {
+				throw std::runtime_error(_error);
+			}
+			_pending[sequence].data.swap(buffer);
+			_pending[sequence].lines = lines;
+			_pending[sequence].pieces.swap(pieces);
+			_reordered = std::max(_reordered, _pending.size());
+			// Release every consecutive buffer to the writer
+			while (!_pending.empty() && _pending.begin()->first == _released) {
+				_queue.emplace_back(std::move(_pending.begin()->second));
+				_pending.erase(_pending.begin());
+				_released++;
+			}
+		}
+		_notEmpty.notify_one();
+		_notFull.notify_all();
+		buffer = acquire();
+	}
+
+	/// <summary> Writes all queued buffers, stops the writer thread and closes the file. </summary>
+	/// <remarks> BlueWingTan, 2026/10/19. </remarks>
+	/// <exception cref="std::runtime_error"> Thrown when the writer failed. </exception>
+	void close() {
+		if (!_thread.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_closing = true;
+		}
+		_notEmpty.notify_one();
+		_thread.join();
+		if (_format == output_format_t::INDEXED && _error.empty()) {
+			const auto trailer = encode_indexed_trailer(_index, _records, _bytes, _metadata);
+			if (!output(trailer.data(), trailer.size())) {
+				_error = std::string("failed to write ") + _path + ": " + std::strerror(errno);
+			}
+			_bytes += trailer.size();
+			_fileBytes += trailer.size();
+		}
+		if (_uring != nullptr) {
+			if (!_uring->finish() && _error.empty()) {
+				_error = std::string("failed to write ") + _path + ": " + std::strerror(errno);
+			}
+			_stalls += _uring->stalls();
+			_uring.reset();
+		}
+		_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+		if (_owned && !detail::close_output(_descriptor) && _error.empty()) {
+			_error = "failed to close " + _path + ": " + std::strerror(errno);
+		}
+		_files.push_back({ _path, _fileLines, _fileBytes });
+		if (!_pending.empty() && _error.empty()) {
+			_error = "buffer " + std::to_string(_released) + " of " + _path + " never arrived";
+		}
+		if (!_error.empty()) {
+			throw std::runtime_error(_error);
+		}
+	}
+
+	/// <summary> Sets the metadata written into the footer of the indexed file on close. </summary>
+	/// <param name="metadata"> The metadata. </param>
+	void describe(const std::string& metadata) {
+		std::lock_guard<std::mutex> lock(_lock);
+		_metadata = metadata;
+	}
+
+	/// <summary> Gets the output file path, the last file if files are rotated. </summary>
+	const std::string& path() const { return _path; }
+
+	/// <summary> Gets every file written in order, available after close. </summary>
+	const std::vector<output_file_t>& files() const { return _files; }
+
+	/// <summary> Number of bytes written. </summary>
+	std::uint64_t bytes() const { return _bytes; }
+
+	/// <summary> Number of lines handed off, before compression. </summary>
+	std::uint64_t lines() const { return _lines; }
+
+	/// <summary> Seconds from open to close. </summary>
+	double elapsed() const { return _elapsed; }
+
+	/// <summary> Seconds the writer thread spent in write calls. </summary>
+	double busy() const { return _busy; }
+
+	/// <summary> Seconds workers spent waiting for a full queue. </summary>
+	double waited() const { return _waited; }
+
+	/// <summary> Query if the consumer closed the stream. </summary>
+	bool broken() const { return _broken; }
+
+	/// <summary> Query if buffers are spliced into a pipe instead of copied. </summary>
+	bool spliced() const { return _pipeCapacity > 0; }
+
+	/// <summary> Maximum number of buffers held by the reorder buffer. </summary>
+	std::size_t reordered() const { return _reordered; }
+
+	/// <summary> Gets the backend that writes the file. </summary>
+	io_backend_t backend() const { return _backend; }
+
+	/// <summary> Query if the file is opened with O_DIRECT. </summary>
+	bool direct() const { return _direct; }
+
+	/// <summary> Gets why the requested backend or O_DIRECT is not used, empty if it is used. </summary>
+	const std::string& fallback() const { return _fallback; }
+
+	/// <summary> Number of times the writer waited for a free io_uring slot. </summary>
+	std::uint64_t stalls() const { return _uring != nullptr ? _uring->stalls() : _stalls; }
+
+private:
+	/// <summary> A buffer handed off with its number of lines. </summary>
+	using block_t = struct {
+		std::string data;
+		std::uint64_t lines;
+		std::vector<std::pair<std::size_t, std::uint64_t>> pieces;	// Bytes and lines of pieces compressed on their own, empty if not compressed
+	};
+
+	/// <summary> Writer thread, writes queued buffers in order until closed. </summary>
+	void run() {
+		std::unique_lock<std::mutex> lock(_lock);
+		while (true) {
+			_notEmpty.wait(lock, [&]() { return !_queue.empty() || _closing; });
+			if (_queue.empty()) {
+				return;
+			}
+			auto block = std::move(_queue.front());
+			auto& buffer = block.data;
+			_queue.pop_front();
+			lock.unlock();
+			_notFull.notify_all();
+
+			if (_format == output_format_t::INDEXED && !buffer.empty()) {
+				_index.emplace_back(_records, _bytes);
+				_records += indexed_block_records(buffer);
+			}
+			const auto start = std::chrono::steady_clock::now();
+			// The server takes the buffer itself and waits while its clients are behind, so the size is kept first
+			const auto size = buffer.size();
+			const auto rotating = _rotateBytes > 0 || _rotateLines > 0;
+			const auto succeed = _error.empty() &&
+				(_server != nullptr ? size == 0 || _server->push(buffer) : rotating ? output_rotated(block) : output(buffer.data(), size));
+			const auto broken = !succeed && errno == EPIPE;
+			const auto error = succeed ? std::string() : std::string(broken ? "consumer closed " : "failed to write ") + _path + ": " + std::strerror(errno);
+			_busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			_bytes += succeed ? size : 0;
+			_fileBytes += succeed && !rotating ? size : 0;
+			_fileLines += succeed && !rotating ? block.lines : 0;
+
+			lock.lock();
+			if (!succeed && _error.empty()) {
+				// Workers waiting on a full queue must see the error
+				_error = error;
+				_broken = broken;
+				_notFull.notify_all();
+			}
+			recycle(buffer);
+		}
+	}
+
+	/// <summary>
+	///		<para> Writes the block across as many files as the limits require, files are switched only at line boundaries. </para>
+	///		<para> Text is split at any line, compressed blocks only between their pieces. A file exceeds the limits only if a single line or piece does. </para>
+	///	</summary>
+	/// <param name="block"> The block to write. </param>
+	/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+	bool output_rotated(const block_t& block) {
+		const auto unlimited = std::numeric_limits<std::uint64_t>::max();
+		std::size_t offset = 0;
+		std::size_t piece = 0;
+		while (offset < block.data.size()) {
+			const auto empty = _fileBytes == 0 && _fileLines == 0;
+			const auto roomBytes = _rotateBytes > 0 ? _rotateBytes - std::min(_fileBytes, _rotateBytes) : unlimited;
+			const auto roomLines = _rotateLines > 0 ? _rotateLines - std::min(_fileLines, _rotateLines) : unlimited;
+			std::size_t size = 0;
+			std::uint64_t lines = 0;
+			if (block.pieces.empty()) {
+				size = detail::fit_lines(block.data.data() + offset, block.data.size() - offset, roomBytes, roomLines, empty, lines);
+			} else if (empty || (block.pieces[piece].first <= roomBytes && block.pieces[piece].second <= roomLines)) {
+				size = block.pieces[piece].first;
+				lines = block.pieces[piece++].second;
+			}
+			if (size == 0) {
+				if (!rotate()) {
+					return false;
+				}
+				continue;
+			}
+			if (!output(block.data.data() + offset, size)) {
+				return false;
+			}
+			offset += size;
+			_fileBytes += size;
+			_fileLines += lines;
+		}
+		return true;
+	}
+
+	/// <summary> Closes the current file and opens the next one, the closed file is announced. </summary>
+	/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+	bool rotate() {
+		if (_uring != nullptr) {
+			if (!_uring->finish()) {
+				return false;
+			}
+			_stalls += _uring->stalls();
+			_uring.reset();
+		}
+		if (!detail::close_output(_descriptor)) {
+			_descriptor = -1;
+			return false;
+		}
+		_files.push_back({ _path, _fileLines, _fileBytes });
+		if (_rotated) {
+			_rotated(_files.back());
+		}
+		_path = detail::rotated_path(_basePath, _files.size());
+		_fileBytes = 0;
+		_fileLines = 0;
+		_descriptor = detail::open_output(_path, _direct);
+		if (_descriptor < 0) {
+			return false;
+		}
+		if (_backend == io_backend_t::URING) {
+			try {
+				_uring.reset(new UringFile(_descriptor, _direct, _depth * 2, OUTPUT_BUFFER_SIZE));
+			} catch (const std::exception&) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary> Sets up io_uring for the file, the file is written by write(2) if it is not supported. </summary>
+	/// <param name="direct"> True if the file is opened with O_DIRECT. </param>
+	void open_uring(const bool direct) {
+		try {
+			// Twice the queue depth of slots, so that slots are filled while earlier ones are written
+			_uring.reset(new UringFile(_descriptor, direct, _depth * 2, OUTPUT_BUFFER_SIZE));
+			_backend = io_backend_t::URING;
+			_direct = direct;
+			return;
+		} catch (const std::exception& ex) {
+			_fallback = ex.what();
+		}
+		if (direct) {
+			// Buffered writes of any size are not allowed with O_DIRECT, nothing is written yet
+			detail::close_output(_descriptor);
+			_descriptor = detail::open_output(_path);
+			if (_descriptor < 0) {
+				throw std::runtime_error("failed to open " + _path + ": " + std::strerror(errno));
+			}
+		}
+	}
+
+	/// <summary> Writes all bytes through io_uring, a pipe or write(2). </summary>
+	/// <returns> True if it succeeds, false if it fails with errno set. </returns>
+	bool output(const char* data, const std::size_t size) {
+		if (_uring != nullptr) {
+			return _uring->write(data, size);
+		}
+		return _pipeCapacity > 0 ? detail::splice_all(_descriptor, data, size) : detail::write_all(_descriptor, data, size);
+	}
+
+	/// <summary> Counts the lines of the buffer and compresses or encodes it on the calling thread. </summary>
+	/// <param name="buffer"> [in,out] The buffer. </param>
+	/// <param name="pieces"> [out] Bytes and lines of pieces compressed on their own if files are rotated. </param>
+	/// <returns> Number of lines of the buffer. </returns>
+	std::uint64_t encode(std::string& buffer, std::vector<std::pair<std::size_t, std::uint64_t>>& pieces) {
+		const auto lines = static_cast<std::uint64_t>(std::count(buffer.cbegin(), buffer.cend(), '\n'));
+		_lines += lines;
+		if (_format == output_format_t::INDEXED) {
+			// Empty buffers of the reorder buffer stay empty instead of becoming empty blocks
+			if (!buffer.empty()) {
+				encode_indexed_block(buffer);
+			}
+			return lines;
+		}
+		if (_compression != compression_t::NONE && (_rotateBytes > 0 || _rotateLines > 0)) {
+			compress_pieces(buffer, pieces);
+			return lines;
+		}
+		compress_block(_compression, buffer);
+		return lines;
+	}
+
+	/// <summary> Splits the buffer into pieces of whole lines within the limits and compresses each one on its own, so that files switch between them. </summary>
+	/// <param name="buffer"> [in,out] The buffer, replaced by the compressed pieces. </param>
+	/// <param name="pieces"> [out] Compressed bytes and lines of every piece. </param>
+	void compress_pieces(std::string& buffer, std::vector<std::pair<std::size_t, std::uint64_t>>& pieces) {
+		const auto bytes = _rotateBytes > 0 ? _rotateBytes : std::numeric_limits<std::uint64_t>::max();
+		const auto lines = _rotateLines > 0 ? _rotateLines : std::numeric_limits<std::uint64_t>::max();
+		std::string compressed;
+		std::string piece;
+		for (std::size_t offset = 0; offset < buffer.size();) {
+			std::uint64_t taken = 0;
+			const auto size = detail::fit_lines(buffer.data() + offset, buffer.size() - offset, bytes, lines, true, taken);
+			piece.assign(buffer, offset, size);
+			compress_block(_compression, piece);
+			compressed += piece;
+			pieces.emplace_back(piece.size(), taken);
+			offset += size;
+		}
+		buffer.swap(compressed);
+	}
+
+	/// <summary> Recycles the written buffer, the lock must be held. </summary>
+	/// <param name="buffer"> [in,out] The buffer. </param>
+	void recycle(std::string& buffer) {
+		if (_pipeCapacity == 0) {
+			_free.emplace_back(std::move(buffer));
+			return;
+		}
+		// Spliced pages stay in the pipe until they are read, a buffer is reused only after a full pipe of later bytes is spliced
+		_splicedBytes += buffer.size();
+		_spliced.emplace_back(std::move(buffer));
+		while (_splicedBytes - _spliced.front().size() >= _pipeCapacity) {
+			_splicedBytes -= _spliced.front().size();
+			_free.emplace_back(std::move(_spliced.front()));
+			_spliced.pop_front();
+		}
+	}
+
+	std::string _basePath;
+	std::string _path;
+	std::size_t _depth;
+	compression_t _compression;
+	output_format_t _format{ output_format_t::TEXT };
+	std::uint64_t _rotateBytes{ 0 };
+	std::uint64_t _rotateLines{ 0 };
+	std::function<void(const output_file_t&)> _rotated;
+	std::uint64_t _fileBytes{ 0 };
+	std::uint64_t _fileLines{ 0 };
+	std::vector<output_file_t> _files;
+	int _descriptor;
+	io_backend_t _backend{ io_backend_t::BUFFERED };
+	bool _direct{ false };
+	std::string _fallback;
+	std::unique_ptr<UringFile> _uring;
+	std::uint64_t _stalls{ 0 };
+	ChunkServer* _server{ nullptr };
+	bool _owned{ true };
+	std::size_t _pipeCapacity{ 0 };
+	std::deque<std::string> _spliced;
+	std::uint64_t _splicedBytes{ 0 };
+	std::atomic<bool> _broken{ false };
+	std::thread _thread;
+	std::mutex _lock;
+	std::condition_variable _notEmpty;
+	std::condition_variable _notFull;
+	std::deque<block_t> _queue;
+	std::map<std::uint64_t, block_t> _pending;
+	std::uint64_t _released{ 0 };
+	std::size_t _reordered{ 0 };
+	std::vector<std::string> _free;
+	bool _closing{ false };
+	std::string _error;
+	std::chrono::steady_clock::time_point _start;
+	std::uint64_t _bytes{ 0 };
+	std::atomic<std::uint64_t> _lines{ 0 };
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> _index;
+	std::uint64_t _records{ 0 };
+	std::string _metadata;
+	double _elapsed{ 0 };
+	double _busy{ 0 };
+	double _waited{ 0 };
+};
+}	// namespace bwt
@@ -81,20 +81,88 @@ struct ExistingFileDistValidator : public CLI::Validator {
 };
 
 int main(int argc, char** argv) {
-	std::cout << help_content();
+	// Candidates own the standard output when streaming, everything else goes to the standard error
+	const auto toStdout = std::any_of(argv + 1, argv + argc, [](const char* arg) { return std::string(arg) == "--stdout"; });
+	(toStdout ? std::cerr : std::cout) << help_content();
 
 	CLI::App app{};
 	std::string configFileName{ "config.json" };
 	std::size_t threadNumber{ std::thread::hardware_concurrency() };
+	bwt::MakerOption option;
+	std::string sortOrder;
+	std::string manifest;
+	std::string compression;
+	std::string indexed;
+	std::uint64_t rank{ 0 };
+	bool uring{ false };
 	ExistingFileDistValidator validator;
 
 	app.get_formatter()->column_width(40);
 	app.add_option("-c,--config", configFileName, "The configuration filename in ./config path", true)->check(validator);
 	app.add_option("-t,--thread", threadNumber, "How many threads should be used to generate the password", true)->check(CLI::Range(1u, std::thread::hardware_concurrency()));
+	app.add_flag("-n,--count", option.countOnly, "Only count the candidates in keyspace without generating");
+	app.add_flag("-b,--benchmark", option.benchmark, "Compare fused and staged pipelines without generating");
+	auto exact = app.add_flag("-d,--dedupe", option.dedupe, "Drop duplicated candidates across formations and additional dictionaries");
+	auto approximate = app.add_flag("--dedupe-approx", option.dedupeApproximate, "Drop duplicated candidates with a bounded-memory cuckoo filter")->excludes(exact);
+	app.add_option("--fp-rate", option.falsePositiveRate, "False positive rate of approximate dedupe", true)->check(CLI::Range(1e-9, 0.5));
+	app.add_option("--dedupe-memory", option.dedupeMemory, "Memory budget in MB of approximate dedupe", true)->check(CLI::Range(std::size_t(1), std::size_t(1) << 20));
+	app.add_flag("--estimate", option.estimate, "Estimate distinct candidates and duplicate ratio with a HyperLogLog sketch");
+	auto history = app.add_option("--history", option.historyPath, "Fingerprint file of earlier runs, only never emitted candidates are generated and it is updated after the run")->excludes(approximate);
+	auto external = app.add_flag("--unique-external", option.uniqueExternal, "Sort and deduplicate the output with bounded memory through temporary runs");
+	auto sort = app.add_option("--sort", sortOrder, "Sort the output by length or lex order, through temporary runs if it exceeds the run size")->check(CLI::IsMember({ "length", "lex" }));
+	app.add_option("--run-size", option.runSize, "Run size in MB of external sort with its sort index, memory is bounded by about (threads + 1) runs", true)->check(CLI::Range(std::size_t(1), std::size_t(1) << 20));
+	app.add_option("--temp-dir", option.temporaryPath, "Directory of temporary runs of external sort", true)->check(CLI::ExistingDirectory);
+	app.add_option("--partitions", option.partitions, "Split the output into files by fingerprint, each one is deduplicated by its own set")
+		->check(CLI::Range(std::size_t(1), std::size_t(4096)))->excludes(exact)->excludes(approximate)->excludes(history)->excludes(external)->excludes(sort);
+	app.add_option("--shards", option.shards, "Write the output into files in parallel, each one by its own writer, with a manifest of them")
+		->check(CLI::Range(std::size_t(1), std::size_t(4096)))->excludes(external)->excludes(sort)->excludes("--partitions");
+	app.add_flag("--deterministic", option.deterministic, "Write byte-identical output in parallel at planned offsets of a preallocated file")
+		->excludes(exact)->excludes(approximate)->excludes(history)->excludes(external)->excludes(sort)->excludes("--partitions")->excludes("--shards");
+	app.add_flag("--ordered", option.ordered, "Stream the output in deterministic order through a bounded reorder buffer")
+		->excludes(exact)->excludes(approximate)->excludes(history)->excludes(external)->excludes(sort)->excludes("--partitions")->excludes("--shards")->excludes("--deterministic");
+	app.add_flag("--stdout", option.toStdout, "Stream the output to stdout for piping into a cracker, logs go to stderr")
+		->excludes(external)->excludes(sort)->excludes("--partitions")->excludes("--shards")->excludes("--deterministic");
+	app.add_option("--compress", compression, "Compress blocks of the output on the worker threads into a .gz or .zst file")
+		->check(CLI::IsMember({ "gzip", "zstd" }))->excludes(external)->excludes(sort)->excludes("--partitions")->excludes("--deterministic");
+	app.add_flag("--indexed", option.indexed, "Write the output as an indexed candidate file of front-coded blocks for random access")
+		->excludes(external)->excludes(sort)->excludes("--partitions")->excludes("--shards")->excludes("--deterministic")->excludes("--stdout")->excludes("--compress");
+	auto uringFlag = app.add_flag("--io-uring", uring, "Write output files through io_uring on Linux, falls back to write(2) where it is not supported")
+		->excludes(external)->excludes(sort)->excludes("--partitions")->excludes("--deterministic")->excludes("--stdout");
+	app.add_flag("--direct", option.direct, "Open output files with O_DIRECT when they are written through io_uring")->needs(uringFlag);
+	app.add_flag("--benchmark-writer", option.benchmarkWriter, "Compare write(2) and io_uring writers on the same job, outputs are removed")
+		->excludes(external)->excludes(sort)->excludes("--partitions")->excludes("--deterministic")->excludes("--stdout");
+	app.add_option("--rotate-bytes", option.rotateBytes, "Switch the output to the next file before it exceeds this many bytes, files are listed in a manifest")
+		->check(CLI::Range(std::uint64_t(1), std::numeric_limits<std::uint64_t>::max()))->excludes(external)->excludes(sort)->excludes("--partitions")
+		->excludes("--deterministic")->excludes("--stdout")->excludes("--indexed");
+	app.add_option("--rotate-lines", option.rotateLines, "Switch the output to the next file before it exceeds this many lines, files are listed in a manifest")
+		->check(CLI::Range(std::uint64_t(1), std::numeric_limits<std::uint64_t>::max()))->excludes(external)->excludes(sort)->excludes("--partitions")
+		->excludes("--deterministic")->excludes("--stdout")->excludes("--indexed");
+	app.add_option("--serve", option.serve, "Serve disjoint chunks of the output to clients of unix:/path or tcp:host:port, each one asks for chunks by credits")
+		->excludes(external)->excludes(sort)->excludes("--partitions")->excludes("--shards")->excludes("--deterministic")->excludes("--stdout")
+		->excludes("--indexed")->excludes(uringFlag)->excludes("--benchmark-writer")->excludes("--rotate-bytes")->excludes("--rotate-lines");
+	auto convert = app.add_option("--convert", indexed, "Convert the indexed candidate file back to text instead of generating")->check(CLI::ExistingFile);
+	app.add_option("--at", rank, "Look up the candidate of the rank in the indexed candidate file given by --convert instead of converting it")->needs(convert);
+	app.add_option("--concat", manifest, "Concatenate the shards listed in the manifest into one output file instead of generating")->check(CLI::ExistingFile);
 
 	CLI11_PARSE(app, argc, argv);
-
-	bwt::PasswordMaker maker(configFileName, threadNumber);
+	option.sort = !sortOrder.empty();
+	option.sortOrder = (sortOrder == "length") ? bwt::sort_order_t::LENGTH : bwt::sort_order_t::LEXICOGRAPHIC;
+	option.backend = uring ? bwt::io_backend_t::URING : bwt::io_backend_t::BUFFERED;
+	option.compression = compression.empty() ? bwt::compression_t::NONE : (compression == "gzip") ? bwt::compression_t::GZIP : bwt::compression_t::ZSTD;
+
+	bwt::PasswordMaker maker(configFileName, threadNumber, option);
+	if (!indexed.empty()) {
+		if (app.count("--at") > 0) {
+			maker.lookup(indexed, rank);
+		} else {
+			maker.convert(indexed);
+		}
+		return 0;
+	}
+	if (!manifest.empty()) {
+		maker.concat(manifest);
+		return 0;
+	}
 	maker.generate();
 	return 0;
 }